@@ -0,0 +1,5 @@
+#pragma once
+
+#include "armbench.h"
+
+int accuracy_run(const armbench_t *bench, armbench_config_t *config);
@@ -0,0 +1,291 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define ARMBENCH_VERSION "0.3"
+
+typedef struct armbench_s armbench_t;
+
+typedef enum armbench_status_e {
+   ARMBENCH_SUCCESS = 0,
+   ARMBENCH_ERROR_INVALID = -1,
+   ARMBENCH_ERROR_ALLOC = -2,
+   ARMBENCH_ERROR_CPUS = -3,
+   ARMBENCH_ERROR_SYSTEM = -4,
+   ARMBENCH_ERROR_UNSUPPORTED = -5,
+} armbench_status_t;
+
+typedef enum armbench_kind_e {
+   BENCH_KIND_INIT,
+   BENCH_KIND_COPY,
+   BENCH_KIND_REDUC,
+   BENCH_KIND_DOTPROD,
+   BENCH_KIND_GAXPY,
+   BENCH_KIND_SUM,
+   BENCH_KIND_SCALE,
+   BENCH_KIND__MAX,
+} armbench_kind_t;
+
+typedef enum armbench_impl_kind_e {
+   IMPL_KIND_COMPILER,
+   IMPL_KIND_ASSEMBLY,
+   IMPL_KIND__MAX,
+} armbench_impl_kind_t;
+
+typedef enum armbench_cache_mode_e {
+   CACHE_MODE_NONE,
+   CACHE_MODE_HOT,
+   CACHE_MODE_COLD,
+   CACHE_MODE_BOTH,
+   CACHE_MODE__MAX,
+} armbench_cache_mode_t;
+
+typedef enum armbench_bg_load_e {
+   BG_LOAD_NONE,
+   BG_LOAD_COPY,
+   BG_LOAD_INIT,
+   BG_LOAD_RANDOM,
+   BG_LOAD__MAX,
+} armbench_bg_load_t;
+
+/**
+ * Static instruction mix of a kernel, decoded from its machine code.
+ *
+ * Counters other than `function_insns` describe the body of the hot loop,
+ * i.e. one iteration of the innermost loop that holds the most vector
+ * instructions.
+ **/
+typedef struct armbench_insn_mix_s {
+   bool available;
+   size_t function_insns;
+   size_t loop_insns;
+   size_t nb_sve;
+   size_t nb_neon;
+   size_t nb_scalar;
+   size_t nb_loads;
+   size_t nb_stores;
+   size_t nb_fmas;
+   size_t nb_gathers;
+} armbench_insn_mix_t;
+
+/**
+ * Results of the measured kernel while `nb_threads` background threads
+ * load the memory subsystem.
+ **/
+typedef struct armbench_interference_result_s {
+   size_t nb_threads;
+   double compiler_latency;
+   double assembly_latency;
+   double background_bandwidth;
+   bool passed;
+} armbench_interference_result_t;
+
+/**
+ * Throughput of the soaked kernel over one sampling interval, along with
+ * the frequency of the core it ran on and the hottest thermal zone (0 when
+ * sysfs does not expose them).
+ **/
+typedef struct armbench_soak_sample_s {
+   double timestamp;
+   size_t nb_calls;
+   double elapsed;
+   double frequency;
+   double temperature;
+} armbench_soak_sample_t;
+
+/**
+ * Speed and accuracy of one variant of a reduction against the exact result.
+ * `cycles_per_element` is 0 when the cycle counter is not available, and
+ * `bits` is the number of correct bits of the result (53 when exact).
+ **/
+typedef struct armbench_accuracy_result_s {
+   const char *name;
+   double latency;
+   double cycles_per_element;
+   double value;
+   double exact;
+   double error;
+   double bits;
+} armbench_accuracy_result_t;
+
+#define ARMBENCH_DISPATCH_NAME_SIZE 32
+
+/**
+ * Winning variant of `kind` for working sets of `min_bytes` to `max_bytes`
+ * bytes per worker when `nb_threads` workers run concurrently.
+ **/
+typedef struct armbench_dispatch_entry_s {
+   armbench_kind_t kind;
+   size_t nb_threads;
+   size_t min_bytes;
+   size_t max_bytes;
+   char name[ARMBENCH_DISPATCH_NAME_SIZE];
+} armbench_dispatch_entry_t;
+
+/**
+ * Dispatch table, sorted by kind, thread count and size. On disk, it is a
+ * magic header followed by the number of entries and one fixed-size record
+ * per entry, all in native byte order.
+ **/
+typedef struct armbench_dispatch_table_s {
+   armbench_dispatch_entry_t *entries;
+   size_t nb_entries;
+} armbench_dispatch_table_t;
+
+typedef struct armbench_proc_result_s armbench_proc_result_t;
+
+/**
+ * Parameters and results of a run. The detailed results of each mode are
+ * owned by the configuration until `armbench_free_results()`.
+ **/
+typedef struct armbench_config_s {
+   armbench_kind_t benchmark_kind;
+   size_t nb_bytes;
+   size_t nb_repetitions;
+   uint64_t seed;
+   size_t nb_procs;
+   armbench_cache_mode_t cache_mode;
+   armbench_bg_load_t bg_load;
+   size_t nb_bg_threads;
+   size_t bg_duty_cycle;
+   armbench_impl_kind_t impl_kind;
+   double soak_duration;
+   double soak_interval;
+   const char *dispatch_path;
+   bool accuracy;
+   double error_tolerance;
+   double computed_error;
+   double compiler_latency;
+   double assembly_latency;
+   double speedup;
+   double compiler_cold_latency;
+   double assembly_cold_latency;
+   double cold_speedup;
+   bool passed;
+   armbench_insn_mix_t compiler_mix;
+   armbench_insn_mix_t assembly_mix;
+   // `nb_procs` entries
+   armbench_proc_result_t *proc_results;
+   // `nb_bg_threads + 1` entries, from the isolated run up
+   armbench_interference_result_t *interference_results;
+   armbench_soak_sample_t *soak_samples;
+   size_t nb_soak_samples;
+   size_t nb_soak_dropped;
+   armbench_dispatch_table_t *dispatch_table;
+   armbench_accuracy_result_t *accuracy_results;
+   size_t nb_accuracy_results;
+} armbench_config_t;
+
+// Results of one worker process, pinned to `cpu`.
+struct armbench_proc_result_s {
+   int cpu;
+   armbench_config_t config;
+};
+
+/**
+ * Operands of one kernel call. Kernels returning a scalar store the result
+ * of repetition `i` in `r[i]`.
+ **/
+typedef struct armbench_args_s {
+   double k;
+   double *x;
+   double *y;
+   double *r;
+   size_t len;
+} armbench_args_t;
+
+typedef void (*armbench_call_t)(const armbench_args_t *args, const size_t rep);
+
+/**
+ * An implementation of a benchmark kind. `symbol` points to the code whose
+ * instruction mix is reported and may be `NULL`. It must be the start of a
+ * function visible to `dladdr()`: a program linking `libarmbench.a` needs
+ * `-rdynamic` for its own kernels and the built-in ones, or the mix is
+ * reported as unavailable.
+ **/
+typedef struct armbench_kernel_s {
+   const char *name;
+   armbench_kind_t kind;
+   armbench_call_t call;
+   const void *symbol;
+} armbench_kernel_t;
+
+/**
+ * Embeddable benchmark library.
+ *
+ * An `armbench_t` handle owns the registry of kernels and the selection of
+ * the compiler/assembly pair compared for each benchmark kind. Handles share
+ * no state, so that independent handles can be used from different threads.
+ * The library never prints, exits or touches the global `rand()` state:
+ * every function reports failures through an `armbench_status_t`.
+ *
+ * Typical use:
+ *
+ *    armbench_t *bench = armbench_create();
+ *    armbench_config_t config;
+ *    armbench_default_config(&config);
+ *    config.benchmark_kind = BENCH_KIND_REDUC;
+ *    if (armbench_run(bench, &config) == ARMBENCH_SUCCESS) {
+ *       ... read config.compiler_latency, config.speedup, ...
+ *    }
+ *    armbench_free_results(&config);
+ *    armbench_destroy(bench);
+ **/
+
+// Creates a handle with the built-in kernels registered, and the `compiler`
+// and `assembly` ones selected. Returns `NULL` on allocation failure.
+armbench_t *armbench_create(void);
+// Creates an independent handle with the same kernels and selection.
+armbench_t *armbench_clone(const armbench_t *bench);
+void armbench_destroy(armbench_t *bench);
+
+// Adds a kernel to the registry. The name must be unique within its kind and
+// outlive the handle.
+int armbench_register_kernel(armbench_t *bench,
+                             const armbench_kernel_t *kernel);
+const armbench_kernel_t *armbench_find_kernel(const armbench_t *bench,
+                                              const armbench_kind_t kind,
+                                              const char *name);
+const armbench_kernel_t *armbench_kernels(const armbench_t *bench,
+                                          size_t *nb_kernels);
+
+// Selects the registered kernel named `name` as the `role` side (baseline
+// or candidate) of the comparison for `kind`.
+int armbench_select_kernel(armbench_t *bench, const armbench_kind_t kind,
+                           const armbench_impl_kind_t role, const char *name);
+const armbench_kernel_t *
+armbench_selected_kernel(const armbench_t *bench, const armbench_kind_t kind,
+                         const armbench_impl_kind_t role);
+
+void armbench_default_config(armbench_config_t *config);
+// Runs the benchmark described by `config`. When `config->dispatch_path` is
+// set, autotunes every registered variant instead and saves the dispatch
+// table there, and when `config->accuracy` is set, measures the accuracy of
+// every variant of a reduction.
+int armbench_run(const armbench_t *bench, armbench_config_t *config);
+void armbench_free_results(armbench_config_t *config);
+
+const char *armbench_strerror(const int status);
+
+int armbench_dispatch_save(const armbench_dispatch_table_t *table,
+                           const char *path);
+int armbench_dispatch_load(armbench_dispatch_table_t *table, const char *path);
+void armbench_dispatch_destroy(armbench_dispatch_table_t *table);
+// Returns the kernel of `bench` that the table picks for the given working
+// set and thread count, or `NULL` when the table has no entry for `kind` or
+// names a kernel that is not registered.
+const armbench_kernel_t *
+armbench_dispatch_select_kernel(const armbench_t *bench,
+                                const armbench_dispatch_table_t *table,
+                                const armbench_kind_t kind,
+                                const size_t nb_bytes, const size_t nb_threads);
+
+#ifdef __cplusplus
+}
+#endif
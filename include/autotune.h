@@ -0,0 +1,5 @@
+#pragma once
+
+#include "armbench.h"
+
+int autotune_run(const armbench_t *bench, armbench_config_t *config);
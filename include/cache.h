@@ -0,0 +1,5 @@
+#pragma once
+
+#include <stddef.h>
+
+int cache_flush(const void *addr, const size_t size);
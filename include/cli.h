@@ -0,0 +1,7 @@
+#pragma once
+
+#include "armbench.h"
+
+int config_init(armbench_config_t *config, int argc, char *argv[argc + 1]);
+int config_print(const armbench_config_t *config);
+int config_result(const armbench_config_t *config);
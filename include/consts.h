@@ -3,7 +3,22 @@
 #define ALIGNMENT 64
 #define DEFAULT_SIZE 8388608
 #define DEFAULT_REP 10
+#define DEFAULT_PROCS 1
+#define DEFAULT_BG_THREADS 3
+#define DEFAULT_DUTY_CYCLE 100
+#define BACKGROUND_SIZE 67108864
+#define BACKGROUND_CHUNK 1048576
 #define DEFAULT_ERROR 1e-8
+#define DEFAULT_INTERVAL 1.0
+#define WAIT_INTERVAL_US 1000
+#define SOAK_RING_SIZE 1024
+#define SOAK_DRIFT_THRESHOLD 0.05
+#define AUTOTUNE_MIN_SIZE 4096
+#define AUTOTUNE_MARGIN 0.02
+#define DISPATCH_MAGIC "ARMBDSP1"
+#define DISPATCH_MAX_ENTRIES 65536
+#define PAIRWISE_BLOCK 128
+#define ACCURACY_MAX_PARTIALS 64
 #define INTEGER_BASE 10
 #define ONE_GIB 1073741824
 #define ONE_MIB 1048576
@@ -1,11 +1,24 @@
 #pragma once
 
-#include "config.h"
-
-int driver_init(config_t *config);
-int driver_copy(config_t *config);
-int driver_reduc(config_t *config);
-int driver_dotprod(config_t *config);
-int driver_gaxpy(config_t *config);
-int driver_vec_sum(config_t *config);
-int driver_vec_scale(config_t *config);
+#include "armbench.h"
+
+#include <stdbool.h>
+
+struct shm_barrier_s;
+
+// Called right before (`begin`) and after each timed section.
+typedef void (*section_hook_t)(void *data, const bool begin);
+
+/**
+ * Internal state of a run, kept out of the public configuration: the barrier
+ * lining up the worker processes before each timed section and the hook
+ * called around them. Both are optional.
+ **/
+typedef struct run_context_s {
+   struct shm_barrier_s *barrier;
+   section_hook_t section_hook;
+   void *section_data;
+} run_context_t;
+
+int driver_run(const armbench_t *bench, armbench_config_t *config,
+               const run_context_t *context);
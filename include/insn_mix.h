@@ -0,0 +1,5 @@
+#pragma once
+
+#include "armbench.h"
+
+int insn_mix_analyze(const void *function, armbench_insn_mix_t *mix);
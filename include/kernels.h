@@ -1,5 +1,7 @@
 #pragma once
 
+#include "armbench.h"
+
 #include <stddef.h>
 
 /**
@@ -23,6 +25,13 @@ void compiler_vec_sum(double *restrict x, const double *restrict y,
 
 void compiler_vec_scale(const double k, double *restrict x, const size_t len);
 
+void compiler_reduc_pairwise(const double *restrict x, double *r,
+                             const size_t len);
+
+void compiler_dotprod_pairwise(const double *restrict x,
+                               const double *restrict y, double *d,
+                               const size_t len);
+
 /**
  * Hand-written assembly kernels.
  **/
@@ -43,3 +52,16 @@ void assembly_vec_sum(double *restrict x, const double *restrict y,
                       const size_t len);
 
 void assembly_vec_scale(const double k, double *restrict x, const size_t len);
+
+void assembly_reduc_compensated(const double *restrict x, double *r,
+                                const size_t len);
+
+void assembly_reduc_fadda(const double *restrict x, double *r,
+                          const size_t len);
+
+void assembly_dotprod_compensated(const double *restrict x,
+                                  const double *restrict y, double *d,
+                                  const size_t len);
+
+void assembly_dotprod_fadda(const double *restrict x, const double *restrict y,
+                            double *d, const size_t len);
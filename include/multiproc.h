@@ -0,0 +1,19 @@
+#pragma once
+
+#include "armbench.h"
+
+#include <stdatomic.h>
+#include <stddef.h>
+
+/**
+ * Sense-reversing barrier living in a `MAP_SHARED` mapping, used to make
+ * the worker processes enter each timed section together.
+ **/
+typedef struct shm_barrier_s {
+   atomic_size_t count;
+   atomic_size_t generation;
+   size_t nb_procs;
+} shm_barrier_t;
+
+void shm_barrier_wait(shm_barrier_t *barrier);
+int multiproc_run(const armbench_t *bench, armbench_config_t *config);
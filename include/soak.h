@@ -0,0 +1,7 @@
+#pragma once
+
+#include "armbench.h"
+
+// Calls `call` back to back, alternating between both sets of `args`.
+int soak_run(armbench_config_t *config, const armbench_call_t call,
+             const armbench_args_t args[2]);
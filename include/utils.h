@@ -1,9 +1,19 @@
 #pragma once
 
 #include <stddef.h>
+#include <stdint.h>
 #include <time.h>
 
-double rand_double(const double min, const double max);
+typedef struct stats_s {
+   double min;
+   double max;
+   double mean;
+   double stddev;
+} stats_t;
+
+double rand_double(uint64_t *state, const double min, const double max);
+
+double elapsed_ns(const struct timespec start, const struct timespec end);
 
 double compute_avg_latency(const struct timespec start,
                            const struct timespec end,
@@ -11,3 +21,10 @@ double compute_avg_latency(const struct timespec start,
 
 double compute_error(const double *compiler, const double *assembly,
                      const size_t len);
+
+stats_t compute_stats(const double *samples, const size_t len);
+
+// Number of CPUs this process is allowed to run on, at most `CPU_SETSIZE`.
+size_t nb_allowed_cpus(void);
+// Fills `cpus` with up to `max` CPUs this process is allowed to run on.
+size_t allowed_cpus(int *cpus, const size_t max);
@@ -0,0 +1,199 @@
+#define _GNU_SOURCE
+#include "accuracy.h"
+
+#include "armbench.h"
+#include "consts.h"
+#include "kernels.h"
+#include "utils.h"
+
+#include <linux/perf_event.h>
+#include <math.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <time.h>
+#include <unistd.h>
+
+// The exact reference recovers the rounding error of every operation, which
+// value-unsafe optimizations would simplify away (see the Makefile).
+#if defined(__FAST_MATH__)
+#error "accuracy.c must be compiled without -ffast-math"
+#endif
+
+/**
+ * Running sum kept exactly as a non-overlapping expansion of increasing
+ * magnitude (Shewchuk). Doubles span about 2100 bits, so a finite sum never
+ * needs more than about 40 partials.
+ **/
+typedef struct exact_sum_s {
+   double partials[ACCURACY_MAX_PARTIALS];
+   size_t nb_partials;
+} exact_sum_t;
+
+static void exact_add(exact_sum_t *sum, double x)
+{
+   size_t n = 0;
+   for (size_t i = 0; i < sum->nb_partials; ++i) {
+      double y = sum->partials[i];
+      if (fabs(x) < fabs(y)) {
+         const double tmp = x;
+         x = y;
+         y = tmp;
+      }
+      const double hi = x + y;
+      const double lo = y - (hi - x);
+      if (lo != 0.0) {
+         sum->partials[n++] = lo;
+      }
+      x = hi;
+   }
+   sum->partials[n++] = x;
+   sum->nb_partials = n;
+}
+
+// Rounds the expansion to a double, within one ulp of the exact sum.
+static double exact_value(const exact_sum_t *sum)
+{
+   double acc = 0.0;
+   for (size_t i = sum->nb_partials; i > 0; --i) {
+      acc += sum->partials[i - 1];
+   }
+   return acc;
+}
+
+static double exact_reference(const armbench_kind_t kind, const double *x,
+                              const double *y, const size_t len)
+{
+   exact_sum_t sum = { .nb_partials = 0 };
+   for (size_t i = 0; i < len; ++i) {
+      if (kind == BENCH_KIND_DOTPROD) {
+         // The product is exactly `p + e`
+         const double p = x[i] * y[i];
+         exact_add(&sum, p);
+         exact_add(&sum, fma(x[i], y[i], -p));
+      }
+      else {
+         exact_add(&sum, x[i]);
+      }
+   }
+   return exact_value(&sum);
+}
+
+// Opens a counter of the user-space cycles of the calling thread, or returns
+// -1 when perf events are not available.
+static int open_cycle_counter(void)
+{
+   struct perf_event_attr attr;
+   memset(&attr, 0, sizeof(attr));
+   attr.type = PERF_TYPE_HARDWARE;
+   attr.size = sizeof(attr);
+   attr.config = PERF_COUNT_HW_CPU_CYCLES;
+   attr.disabled = 1;
+   attr.exclude_kernel = 1;
+   attr.exclude_hv = 1;
+   return (int)(syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0));
+}
+
+static void measure_variant(const armbench_config_t *config,
+                            const armbench_kernel_t *kernel,
+                            const armbench_args_t *args, const int counter,
+                            armbench_accuracy_result_t *result)
+{
+   const size_t nb_repetitions = config->nb_repetitions;
+   struct timespec start, end;
+
+   // Operands are primed in cache as in the `hot` cache mode
+   kernel->call(args, 0);
+   if (counter >= 0) {
+      ioctl(counter, PERF_EVENT_IOC_RESET, 0);
+      ioctl(counter, PERF_EVENT_IOC_ENABLE, 0);
+   }
+   clock_gettime(CLOCK_MONOTONIC_RAW, &start);
+   for (size_t i = 0; i < nb_repetitions; ++i) {
+      kernel->call(args, i);
+   }
+   clock_gettime(CLOCK_MONOTONIC_RAW, &end);
+   uint64_t nb_cycles = 0;
+   if (counter >= 0) {
+      ioctl(counter, PERF_EVENT_IOC_DISABLE, 0);
+      if (read(counter, &nb_cycles, sizeof(nb_cycles)) != sizeof(nb_cycles)) {
+         nb_cycles = 0;
+      }
+   }
+
+   result->name = kernel->name;
+   result->latency = compute_avg_latency(start, end, nb_repetitions);
+   result->cycles_per_element =
+      (double)(nb_cycles) / (double)(nb_repetitions * args->len);
+   result->value = args->r[0];
+
+   const double delta = fabs(result->value - result->exact);
+   result->error =
+      result->exact != 0.0 ? delta / fabs(result->exact) : delta;
+   result->bits = result->error > 0.0 ? -log2(result->error) : 53.0;
+   result->bits = fmax(0.0, fmin(53.0, result->bits));
+}
+
+int accuracy_run(const armbench_t *bench, armbench_config_t *config)
+{
+   const armbench_kind_t kind = config->benchmark_kind;
+   const size_t len = config->nb_bytes / sizeof(double);
+   size_t nb_kernels;
+   const armbench_kernel_t *kernels = armbench_kernels(bench, &nb_kernels);
+
+   const bool has_y = kind == BENCH_KIND_DOTPROD;
+   double *x = aligned_alloc(ALIGNMENT, len * sizeof(double));
+   double *y = has_y ? aligned_alloc(ALIGNMENT, len * sizeof(double)) : NULL;
+   double *r = malloc(config->nb_repetitions * sizeof(double));
+   armbench_accuracy_result_t *results =
+      malloc(nb_kernels * sizeof(armbench_accuracy_result_t));
+   if (!x || (has_y && !y) || !r || !results) {
+      free(x);
+      free(y);
+      free(r);
+      free(results);
+      return ARMBENCH_ERROR_ALLOC;
+   }
+
+   // Operands of both signs, so that partial sums cancel and rounding errors
+   // show up. `y` continues the stream of `x` rather than repeating it.
+   uint64_t state = config->seed;
+   for (size_t i = 0; i < len; ++i) {
+      x[i] = rand_double(&state, -1.0, 1.0);
+   }
+   if (has_y) {
+      for (size_t i = 0; i < len; ++i) {
+         y[i] = rand_double(&state, -1.0, 1.0);
+      }
+   }
+   const double exact = exact_reference(kind, x, y, len);
+
+   const armbench_args_t args = { .x = x, .y = y, .r = r, .len = len };
+   const int counter = open_cycle_counter();
+   size_t nb_results = 0;
+   config->passed = false;
+   for (size_t i = 0; i < nb_kernels; ++i) {
+      if (kernels[i].kind != kind) {
+         continue;
+      }
+      armbench_accuracy_result_t *result = results + nb_results++;
+      result->exact = exact;
+      measure_variant(config, kernels + i, &args, counter, result);
+      if (result->error <= config->error_tolerance) {
+         config->passed = true;
+      }
+   }
+   if (counter >= 0) {
+      close(counter);
+   }
+
+   free(x);
+   free(y);
+   free(r);
+   config->accuracy_results = results;
+   config->nb_accuracy_results = nb_results;
+   return ARMBENCH_SUCCESS;
+}
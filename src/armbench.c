@@ -0,0 +1,462 @@
+#include "armbench.h"
+
+#include "accuracy.h"
+#include "autotune.h"
+#include "consts.h"
+#include "drivers.h"
+#include "interference.h"
+#include "kernels.h"
+#include "multiproc.h"
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+struct armbench_s {
+   armbench_kernel_t *kernels;
+   size_t nb_kernels;
+   size_t max_kernels;
+   // Indices in `kernels` of the selected pair for each kind, or `SIZE_MAX`
+   size_t selected[BENCH_KIND__MAX][IMPL_KIND__MAX];
+};
+
+static void call_compiler_init(const armbench_args_t *args, const size_t rep)
+{
+   (void)rep;
+   compiler_init(args->k, args->x, args->len);
+}
+
+static void call_assembly_init(const armbench_args_t *args, const size_t rep)
+{
+   (void)rep;
+   assembly_init(args->k, args->x, args->len);
+}
+
+static void call_compiler_copy(const armbench_args_t *args, const size_t rep)
+{
+   (void)rep;
+   compiler_copy(args->x, args->y, args->len);
+}
+
+static void call_assembly_copy(const armbench_args_t *args, const size_t rep)
+{
+   (void)rep;
+   assembly_copy(args->x, args->y, args->len);
+}
+
+static void call_compiler_reduc(const armbench_args_t *args, const size_t rep)
+{
+   compiler_reduc(args->x, args->r + rep, args->len);
+}
+
+static void call_assembly_reduc(const armbench_args_t *args, const size_t rep)
+{
+   assembly_reduc(args->x, args->r + rep, args->len);
+}
+
+static void call_compiler_dotprod(const armbench_args_t *args, const size_t rep)
+{
+   compiler_dotprod(args->x, args->y, args->r + rep, args->len);
+}
+
+static void call_assembly_dotprod(const armbench_args_t *args, const size_t rep)
+{
+   assembly_dotprod(args->x, args->y, args->r + rep, args->len);
+}
+
+static void call_compiler_gaxpy(const armbench_args_t *args, const size_t rep)
+{
+   (void)rep;
+   compiler_gaxpy(args->k, args->x, args->y, args->len);
+}
+
+static void call_assembly_gaxpy(const armbench_args_t *args, const size_t rep)
+{
+   (void)rep;
+   assembly_gaxpy(args->k, args->x, args->y, args->len);
+}
+
+static void call_compiler_vec_sum(const armbench_args_t *args, const size_t rep)
+{
+   (void)rep;
+   compiler_vec_sum(args->x, args->y, args->len);
+}
+
+static void call_assembly_vec_sum(const armbench_args_t *args, const size_t rep)
+{
+   (void)rep;
+   assembly_vec_sum(args->x, args->y, args->len);
+}
+
+static void call_compiler_vec_scale(const armbench_args_t *args,
+                                    const size_t rep)
+{
+   (void)rep;
+   compiler_vec_scale(args->k, args->x, args->len);
+}
+
+static void call_assembly_vec_scale(const armbench_args_t *args,
+                                    const size_t rep)
+{
+   (void)rep;
+   assembly_vec_scale(args->k, args->x, args->len);
+}
+
+static void call_pairwise_reduc(const armbench_args_t *args, const size_t rep)
+{
+   compiler_reduc_pairwise(args->x, args->r + rep, args->len);
+}
+
+static void call_compensated_reduc(const armbench_args_t *args,
+                                   const size_t rep)
+{
+   assembly_reduc_compensated(args->x, args->r + rep, args->len);
+}
+
+static void call_fadda_reduc(const armbench_args_t *args, const size_t rep)
+{
+   assembly_reduc_fadda(args->x, args->r + rep, args->len);
+}
+
+static void call_pairwise_dotprod(const armbench_args_t *args, const size_t rep)
+{
+   compiler_dotprod_pairwise(args->x, args->y, args->r + rep, args->len);
+}
+
+static void call_compensated_dotprod(const armbench_args_t *args,
+                                     const size_t rep)
+{
+   assembly_dotprod_compensated(args->x, args->y, args->r + rep, args->len);
+}
+
+static void call_fadda_dotprod(const armbench_args_t *args, const size_t rep)
+{
+   assembly_dotprod_fadda(args->x, args->y, args->r + rep, args->len);
+}
+
+// Built-in pair of kernels for one benchmark kind.
+#define BUILTIN_KERNELS(kind, suffix)                                        \
+   { "compiler", kind, call_compiler_##suffix,                               \
+     (const void *)compiler_##suffix },                                      \
+   { "assembly", kind, call_assembly_##suffix,                               \
+     (const void *)assembly_##suffix }
+
+static const armbench_kernel_t builtin_kernels[] = {
+   BUILTIN_KERNELS(BENCH_KIND_INIT, init),
+   BUILTIN_KERNELS(BENCH_KIND_COPY, copy),
+   BUILTIN_KERNELS(BENCH_KIND_REDUC, reduc),
+   BUILTIN_KERNELS(BENCH_KIND_DOTPROD, dotprod),
+   BUILTIN_KERNELS(BENCH_KIND_GAXPY, gaxpy),
+   BUILTIN_KERNELS(BENCH_KIND_SUM, vec_sum),
+   BUILTIN_KERNELS(BENCH_KIND_SCALE, vec_scale),
+   // Accuracy variants of the reductions
+   { "pairwise", BENCH_KIND_REDUC, call_pairwise_reduc,
+     (const void *)compiler_reduc_pairwise },
+   { "compensated", BENCH_KIND_REDUC, call_compensated_reduc,
+     (const void *)assembly_reduc_compensated },
+   { "fadda", BENCH_KIND_REDUC, call_fadda_reduc,
+     (const void *)assembly_reduc_fadda },
+   { "pairwise", BENCH_KIND_DOTPROD, call_pairwise_dotprod,
+     (const void *)compiler_dotprod_pairwise },
+   { "compensated", BENCH_KIND_DOTPROD, call_compensated_dotprod,
+     (const void *)assembly_dotprod_compensated },
+   { "fadda", BENCH_KIND_DOTPROD, call_fadda_dotprod,
+     (const void *)assembly_dotprod_fadda },
+};
+
+static size_t find_index(const armbench_t *bench, const armbench_kind_t kind,
+                         const char *name)
+{
+   for (size_t i = 0; i < bench->nb_kernels; ++i) {
+      const armbench_kernel_t *kernel = bench->kernels + i;
+      if (kernel->kind == kind && !strcmp(kernel->name, name)) {
+         return i;
+      }
+   }
+   return SIZE_MAX;
+}
+
+armbench_t *armbench_create(void)
+{
+   armbench_t *bench = calloc(1, sizeof(armbench_t));
+   if (!bench) {
+      return NULL;
+   }
+   for (size_t i = 0; i < BENCH_KIND__MAX; ++i) {
+      for (size_t j = 0; j < IMPL_KIND__MAX; ++j) {
+         bench->selected[i][j] = SIZE_MAX;
+      }
+   }
+
+   const size_t nb_builtins =
+      sizeof(builtin_kernels) / sizeof(builtin_kernels[0]);
+   for (size_t i = 0; i < nb_builtins; ++i) {
+      const armbench_kernel_t *kernel = builtin_kernels + i;
+      if (armbench_register_kernel(bench, kernel)) {
+         armbench_destroy(bench);
+         return NULL;
+      }
+      if (!strcmp(kernel->name, "compiler")) {
+         armbench_select_kernel(bench, kernel->kind, IMPL_KIND_COMPILER,
+                                kernel->name);
+      }
+      else if (!strcmp(kernel->name, "assembly")) {
+         armbench_select_kernel(bench, kernel->kind, IMPL_KIND_ASSEMBLY,
+                                kernel->name);
+      }
+   }
+
+   return bench;
+}
+
+armbench_t *armbench_clone(const armbench_t *bench)
+{
+   if (!bench) {
+      return NULL;
+   }
+   armbench_t *clone = malloc(sizeof(armbench_t));
+   if (!clone) {
+      return NULL;
+   }
+   *clone = *bench;
+   clone->kernels = malloc(bench->max_kernels * sizeof(armbench_kernel_t));
+   if (bench->max_kernels && !clone->kernels) {
+      free(clone);
+      return NULL;
+   }
+   memcpy(clone->kernels, bench->kernels,
+          bench->nb_kernels * sizeof(armbench_kernel_t));
+   return clone;
+}
+
+void armbench_destroy(armbench_t *bench)
+{
+   if (!bench) {
+      return;
+   }
+   free(bench->kernels);
+   free(bench);
+}
+
+int armbench_register_kernel(armbench_t *bench,
+                             const armbench_kernel_t *kernel)
+{
+   if (!bench || !kernel || !kernel->name || !kernel->call ||
+       kernel->kind >= BENCH_KIND__MAX ||
+       find_index(bench, kernel->kind, kernel->name) != SIZE_MAX) {
+      return ARMBENCH_ERROR_INVALID;
+   }
+
+   if (bench->nb_kernels == bench->max_kernels) {
+      const size_t max_kernels =
+         bench->max_kernels ? 2 * bench->max_kernels : BENCH_KIND__MAX;
+      armbench_kernel_t *kernels =
+         realloc(bench->kernels, max_kernels * sizeof(armbench_kernel_t));
+      if (!kernels) {
+         return ARMBENCH_ERROR_ALLOC;
+      }
+      bench->kernels = kernels;
+      bench->max_kernels = max_kernels;
+   }
+   bench->kernels[bench->nb_kernels++] = *kernel;
+   return ARMBENCH_SUCCESS;
+}
+
+const armbench_kernel_t *armbench_find_kernel(const armbench_t *bench,
+                                              const armbench_kind_t kind,
+                                              const char *name)
+{
+   if (!bench || !name) {
+      return NULL;
+   }
+   const size_t i = find_index(bench, kind, name);
+   return i == SIZE_MAX ? NULL : bench->kernels + i;
+}
+
+const armbench_kernel_t *armbench_kernels(const armbench_t *bench,
+                                          size_t *nb_kernels)
+{
+   if (!bench || !nb_kernels) {
+      return NULL;
+   }
+   *nb_kernels = bench->nb_kernels;
+   return bench->kernels;
+}
+
+int armbench_select_kernel(armbench_t *bench, const armbench_kind_t kind,
+                           const armbench_impl_kind_t role, const char *name)
+{
+   if (!bench || !name || kind >= BENCH_KIND__MAX ||
+       role >= IMPL_KIND__MAX) {
+      return ARMBENCH_ERROR_INVALID;
+   }
+   const size_t i = find_index(bench, kind, name);
+   if (i == SIZE_MAX) {
+      return ARMBENCH_ERROR_INVALID;
+   }
+   bench->selected[kind][role] = i;
+   return ARMBENCH_SUCCESS;
+}
+
+const armbench_kernel_t *
+armbench_selected_kernel(const armbench_t *bench, const armbench_kind_t kind,
+                         const armbench_impl_kind_t role)
+{
+   if (!bench || kind >= BENCH_KIND__MAX || role >= IMPL_KIND__MAX) {
+      return NULL;
+   }
+   const size_t i = bench->selected[kind][role];
+   return i == SIZE_MAX ? NULL : bench->kernels + i;
+}
+
+void armbench_default_config(armbench_config_t *config)
+{
+   *config = (armbench_config_t){
+      .benchmark_kind = BENCH_KIND__MAX,
+      .nb_bytes = DEFAULT_SIZE,
+      .nb_repetitions = DEFAULT_REP,
+      .seed = 0,
+      .nb_procs = DEFAULT_PROCS,
+      .cache_mode = CACHE_MODE_NONE,
+      .bg_load = BG_LOAD_NONE,
+      .nb_bg_threads = DEFAULT_BG_THREADS,
+      .bg_duty_cycle = DEFAULT_DUTY_CYCLE,
+      .impl_kind = IMPL_KIND_ASSEMBLY,
+      .soak_duration = 0.0,
+      .soak_interval = DEFAULT_INTERVAL,
+      .dispatch_path = NULL,
+      .accuracy = false,
+      .error_tolerance = DEFAULT_ERROR,
+      .computed_error = 0.0,
+      .compiler_latency = 0.0,
+      .assembly_latency = 0.0,
+      .speedup = 0.0,
+      .compiler_cold_latency = 0.0,
+      .assembly_cold_latency = 0.0,
+      .cold_speedup = 0.0,
+      .passed = false,
+      .compiler_mix = { .available = false },
+      .assembly_mix = { .available = false },
+      .proc_results = NULL,
+      .interference_results = NULL,
+      .soak_samples = NULL,
+      .nb_soak_samples = 0,
+      .nb_soak_dropped = 0,
+      .dispatch_table = NULL,
+      .accuracy_results = NULL,
+      .nb_accuracy_results = 0,
+   };
+}
+
+static int validate_config(const armbench_config_t *config)
+{
+   // Autotuning sweeps every kind unless one is given
+   if (config->benchmark_kind > BENCH_KIND__MAX ||
+       (config->benchmark_kind == BENCH_KIND__MAX && !config->dispatch_path) ||
+       config->nb_bytes < sizeof(double) || !config->nb_repetitions ||
+       !config->nb_procs || config->cache_mode >= CACHE_MODE__MAX ||
+       config->bg_load >= BG_LOAD__MAX || !config->bg_duty_cycle ||
+       config->bg_duty_cycle > 100 || config->impl_kind >= IMPL_KIND__MAX ||
+       config->soak_duration < 0.0 || config->soak_interval <= 0.0) {
+      return ARMBENCH_ERROR_INVALID;
+   }
+
+   // Modes that cannot be combined
+   if (config->bg_load != BG_LOAD_NONE && config->nb_procs > 1) {
+      return ARMBENCH_ERROR_INVALID;
+   }
+   if (config->soak_duration > 0.0 &&
+       (config->bg_load != BG_LOAD_NONE || config->nb_procs > 1)) {
+      return ARMBENCH_ERROR_INVALID;
+   }
+   if (config->dispatch_path &&
+       (config->bg_load != BG_LOAD_NONE || config->soak_duration > 0.0)) {
+      return ARMBENCH_ERROR_INVALID;
+   }
+   if (config->accuracy &&
+       ((config->benchmark_kind != BENCH_KIND_REDUC &&
+         config->benchmark_kind != BENCH_KIND_DOTPROD) ||
+        config->nb_procs > 1 || config->bg_load != BG_LOAD_NONE ||
+        config->soak_duration > 0.0 || config->dispatch_path)) {
+      return ARMBENCH_ERROR_INVALID;
+   }
+   return ARMBENCH_SUCCESS;
+}
+
+int armbench_run(const armbench_t *bench, armbench_config_t *config)
+{
+   if (!bench || !config) {
+      return ARMBENCH_ERROR_INVALID;
+   }
+   const int ret = validate_config(config);
+   if (ret) {
+      return ret;
+   }
+
+   config->passed = false;
+   config->proc_results = NULL;
+   config->interference_results = NULL;
+   config->soak_samples = NULL;
+   config->nb_soak_samples = 0;
+   config->nb_soak_dropped = 0;
+   config->dispatch_table = NULL;
+   config->accuracy_results = NULL;
+   config->nb_accuracy_results = 0;
+
+   if (config->accuracy) {
+      return accuracy_run(bench, config);
+   }
+   if (config->dispatch_path) {
+      return autotune_run(bench, config);
+   }
+   if (config->nb_procs > 1) {
+      return multiproc_run(bench, config);
+   }
+   if (config->bg_load != BG_LOAD_NONE) {
+      return interference_run(bench, config);
+   }
+   const run_context_t context = { 0 };
+   return driver_run(bench, config, &context);
+}
+
+void armbench_free_results(armbench_config_t *config)
+{
+   if (!config) {
+      return;
+   }
+   free(config->proc_results);
+   free(config->interference_results);
+   free(config->soak_samples);
+   free(config->accuracy_results);
+   if (config->dispatch_table) {
+      armbench_dispatch_destroy(config->dispatch_table);
+      free(config->dispatch_table);
+   }
+   config->proc_results = NULL;
+   config->interference_results = NULL;
+   config->soak_samples = NULL;
+   config->nb_soak_samples = 0;
+   config->dispatch_table = NULL;
+   config->accuracy_results = NULL;
+   config->nb_accuracy_results = 0;
+}
+
+const char *armbench_strerror(const int status)
+{
+   switch (status) {
+      case ARMBENCH_SUCCESS:
+         return "success";
+      case ARMBENCH_ERROR_INVALID:
+         return "invalid argument";
+      case ARMBENCH_ERROR_ALLOC:
+         return "memory allocation failed";
+      case ARMBENCH_ERROR_CPUS:
+         return "not enough CPUs available";
+      case ARMBENCH_ERROR_SYSTEM:
+         return "system call failed";
+      case ARMBENCH_ERROR_UNSUPPORTED:
+         return "not supported on this architecture";
+      default:
+         return "unknown error";
+   }
+}
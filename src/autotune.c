@@ -0,0 +1,351 @@
+#include "autotune.h"
+
+#include "armbench.h"
+#include "consts.h"
+#include "kernels.h"
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/**
+ * On-disk layout of one dispatch entry.
+ **/
+typedef struct dispatch_record_s {
+   uint32_t kind;
+   uint32_t nb_threads;
+   uint64_t min_bytes;
+   uint64_t max_bytes;
+   char name[ARMBENCH_DISPATCH_NAME_SIZE];
+} dispatch_record_t;
+
+// Sweeps are done in powers of two from `min`, always ending with `max`.
+static inline size_t sweep_next(const size_t value, const size_t max)
+{
+   if (value >= max) {
+      return 0;
+   }
+   return 2 * value < max ? 2 * value : max;
+}
+
+static int push_entry(armbench_dispatch_table_t *table,
+                      const armbench_dispatch_entry_t *entry,
+                      size_t *max_entries)
+{
+   if (table->nb_entries == *max_entries) {
+      const size_t new_max = *max_entries ? 2 * *max_entries : 16;
+      armbench_dispatch_entry_t *entries =
+         realloc(table->entries, new_max * sizeof(armbench_dispatch_entry_t));
+      if (!entries) {
+         return ARMBENCH_ERROR_ALLOC;
+      }
+      table->entries = entries;
+      *max_entries = new_max;
+   }
+   table->entries[table->nb_entries++] = *entry;
+   return ARMBENCH_SUCCESS;
+}
+
+// Records the winner of one point of a sweep ending at `max_bytes`, merging
+// it into the previous range when the same variant also won the size right
+// before it. A range never spans a size that no variant passed.
+static int add_point(armbench_dispatch_table_t *table, size_t *max_entries,
+                     const armbench_kind_t kind, const size_t nb_threads,
+                     const size_t nb_bytes, const size_t max_bytes,
+                     const char *name)
+{
+   if (table->nb_entries) {
+      armbench_dispatch_entry_t *last = table->entries + table->nb_entries - 1;
+      if (last->kind == kind && last->nb_threads == nb_threads &&
+          sweep_next(last->max_bytes, max_bytes) == nb_bytes &&
+          !strcmp(last->name, name)) {
+         last->max_bytes = nb_bytes;
+         return ARMBENCH_SUCCESS;
+      }
+   }
+
+   if (strlen(name) >= ARMBENCH_DISPATCH_NAME_SIZE) {
+      return ARMBENCH_ERROR_INVALID;
+   }
+   armbench_dispatch_entry_t entry = {
+      .kind = kind,
+      .nb_threads = nb_threads,
+      .min_bytes = nb_bytes,
+      .max_bytes = nb_bytes,
+   };
+   strcpy(entry.name, name);
+   return push_entry(table, &entry, max_entries);
+}
+
+/**
+ * Times `kernel` as the candidate against the selected baseline, so that a
+ * variant producing wrong results can never win. The returned latency is 0
+ * when the variant failed the error tolerance.
+ **/
+static int measure_variant(armbench_t *tuned, const armbench_config_t *config,
+                           const armbench_kernel_t *kernel,
+                           const size_t nb_bytes, const size_t nb_threads,
+                           double *latency)
+{
+   int ret = armbench_select_kernel(tuned, kernel->kind, IMPL_KIND_ASSEMBLY,
+                                    kernel->name);
+   if (ret) {
+      return ret;
+   }
+
+   armbench_config_t run = *config;
+   run.benchmark_kind = kernel->kind;
+   run.nb_bytes = nb_bytes;
+   run.nb_procs = nb_threads;
+   run.dispatch_path = NULL;
+   ret = armbench_run(tuned, &run);
+   *latency = run.passed ? run.assembly_latency : 0.0;
+   armbench_free_results(&run);
+   return ret;
+}
+
+static int tune_kind(armbench_t *tuned, armbench_config_t *config,
+                     const armbench_kind_t kind,
+                     armbench_dispatch_table_t *table, size_t *max_entries)
+{
+   size_t nb_kernels;
+   const armbench_kernel_t *kernels = armbench_kernels(tuned, &nb_kernels);
+
+   for (size_t nb_threads = 1; nb_threads;
+        nb_threads = sweep_next(nb_threads, config->nb_procs)) {
+      const char *previous = NULL;
+      const size_t min_bytes = config->nb_bytes < AUTOTUNE_MIN_SIZE
+                                  ? config->nb_bytes
+                                  : AUTOTUNE_MIN_SIZE;
+      for (size_t nb_bytes = min_bytes; nb_bytes;
+           nb_bytes = sweep_next(nb_bytes, config->nb_bytes)) {
+         const char *winner = NULL;
+         double best = 0.0, previous_latency = 0.0;
+         for (size_t i = 0; i < nb_kernels; ++i) {
+            if (kernels[i].kind != kind) {
+               continue;
+            }
+            double latency;
+            const int ret = measure_variant(tuned, config, kernels + i,
+                                            nb_bytes, nb_threads, &latency);
+            if (ret) {
+               return ret;
+            }
+            if (latency > 0.0 && (!winner || latency < best)) {
+               winner = kernels[i].name;
+               best = latency;
+            }
+            if (previous && !strcmp(kernels[i].name, previous)) {
+               previous_latency = latency;
+            }
+         }
+
+         // Keep the winner of the previous size unless it is clearly beaten,
+         // so that noise does not split the table into tiny ranges
+         if (previous_latency > 0.0 &&
+             previous_latency <= best * (1.0 + AUTOTUNE_MARGIN)) {
+            winner = previous;
+         }
+
+         if (!winner) {
+            config->passed = false;
+            previous = NULL;
+            continue;
+         }
+         const int ret = add_point(table, max_entries, kind, nb_threads,
+                                   nb_bytes, config->nb_bytes, winner);
+         if (ret) {
+            return ret;
+         }
+         previous = winner;
+      }
+   }
+   return ARMBENCH_SUCCESS;
+}
+
+int autotune_run(const armbench_t *bench, armbench_config_t *config)
+{
+   // Variants are selected on a private copy of the handle
+   armbench_t *tuned = armbench_clone(bench);
+   armbench_dispatch_table_t *table =
+      calloc(1, sizeof(armbench_dispatch_table_t));
+   if (!tuned || !table) {
+      armbench_destroy(tuned);
+      free(table);
+      return ARMBENCH_ERROR_ALLOC;
+   }
+
+   const bool all_kinds = config->benchmark_kind == BENCH_KIND__MAX;
+   const armbench_kind_t first = all_kinds ? 0 : config->benchmark_kind;
+   const armbench_kind_t last = all_kinds ? BENCH_KIND__MAX - 1
+                                       : config->benchmark_kind;
+   size_t max_entries = 0;
+   int ret = ARMBENCH_SUCCESS;
+   config->passed = true;
+   for (armbench_kind_t kind = first; kind <= last && !ret; ++kind) {
+      ret = tune_kind(tuned, config, kind, table, &max_entries);
+   }
+   if (!ret) {
+      ret = armbench_dispatch_save(table, config->dispatch_path);
+   }
+
+   armbench_destroy(tuned);
+   if (ret) {
+      armbench_dispatch_destroy(table);
+      free(table);
+      return ret;
+   }
+   config->dispatch_table = table;
+   return ARMBENCH_SUCCESS;
+}
+
+int armbench_dispatch_save(const armbench_dispatch_table_t *table,
+                           const char *path)
+{
+   FILE *file = fopen(path, "wb");
+   if (!file) {
+      return ARMBENCH_ERROR_SYSTEM;
+   }
+
+   const uint64_t nb_entries = table->nb_entries;
+   bool ok = fwrite(DISPATCH_MAGIC, 1, 8, file) == 8 &&
+             fwrite(&nb_entries, sizeof(nb_entries), 1, file) == 1;
+   for (size_t i = 0; ok && i < table->nb_entries; ++i) {
+      const armbench_dispatch_entry_t *entry = table->entries + i;
+      dispatch_record_t record = {
+         .kind = (uint32_t)(entry->kind),
+         .nb_threads = (uint32_t)(entry->nb_threads),
+         .min_bytes = entry->min_bytes,
+         .max_bytes = entry->max_bytes,
+      };
+      memcpy(record.name, entry->name, ARMBENCH_DISPATCH_NAME_SIZE);
+      ok = fwrite(&record, sizeof(record), 1, file) == 1;
+   }
+
+   if (fclose(file) || !ok) {
+      return ARMBENCH_ERROR_SYSTEM;
+   }
+   return ARMBENCH_SUCCESS;
+}
+
+static int compare_entries(const void *lhs, const void *rhs)
+{
+   const armbench_dispatch_entry_t *a = lhs;
+   const armbench_dispatch_entry_t *b = rhs;
+   if (a->kind != b->kind) {
+      return a->kind < b->kind ? -1 : 1;
+   }
+   if (a->nb_threads != b->nb_threads) {
+      return a->nb_threads < b->nb_threads ? -1 : 1;
+   }
+   if (a->min_bytes != b->min_bytes) {
+      return a->min_bytes < b->min_bytes ? -1 : 1;
+   }
+   return 0;
+}
+
+int armbench_dispatch_load(armbench_dispatch_table_t *table, const char *path)
+{
+   table->entries = NULL;
+   table->nb_entries = 0;
+   FILE *file = fopen(path, "rb");
+   if (!file) {
+      return ARMBENCH_ERROR_SYSTEM;
+   }
+
+   char magic[8];
+   uint64_t nb_entries;
+   if (fread(magic, 1, 8, file) != 8 || memcmp(magic, DISPATCH_MAGIC, 8) ||
+       fread(&nb_entries, sizeof(nb_entries), 1, file) != 1 ||
+       nb_entries > DISPATCH_MAX_ENTRIES) {
+      fclose(file);
+      return ARMBENCH_ERROR_INVALID;
+   }
+   table->entries = malloc(nb_entries * sizeof(armbench_dispatch_entry_t));
+   if (nb_entries && !table->entries) {
+      fclose(file);
+      return ARMBENCH_ERROR_ALLOC;
+   }
+
+   for (size_t i = 0; i < nb_entries; ++i) {
+      dispatch_record_t record;
+      if (fread(&record, sizeof(record), 1, file) != 1 ||
+          record.kind >= BENCH_KIND__MAX || !record.nb_threads ||
+          record.min_bytes > record.max_bytes ||
+          !memchr(record.name, '\0', ARMBENCH_DISPATCH_NAME_SIZE)) {
+         fclose(file);
+         armbench_dispatch_destroy(table);
+         return ARMBENCH_ERROR_INVALID;
+      }
+      armbench_dispatch_entry_t *entry = table->entries + i;
+      entry->kind = (armbench_kind_t)(record.kind);
+      entry->nb_threads = record.nb_threads;
+      entry->min_bytes = record.min_bytes;
+      entry->max_bytes = record.max_bytes;
+      memcpy(entry->name, record.name, ARMBENCH_DISPATCH_NAME_SIZE);
+   }
+   fclose(file);
+
+   table->nb_entries = nb_entries;
+   qsort(table->entries, table->nb_entries, sizeof(armbench_dispatch_entry_t),
+         compare_entries);
+   return ARMBENCH_SUCCESS;
+}
+
+void armbench_dispatch_destroy(armbench_dispatch_table_t *table)
+{
+   if (!table) {
+      return;
+   }
+   free(table->entries);
+   table->entries = NULL;
+   table->nb_entries = 0;
+}
+
+/**
+ * Picks the entries tuned for the largest thread count that does not exceed
+ * `nb_threads` (or the smallest one available), then the last range starting
+ * at or below `nb_bytes` (or the first one). Sizes between two ranges thus
+ * go to the variant that won the smaller measured size.
+ **/
+const armbench_kernel_t *
+armbench_dispatch_select_kernel(const armbench_t *bench,
+                                const armbench_dispatch_table_t *table,
+                                const armbench_kind_t kind,
+                                const size_t nb_bytes, const size_t nb_threads)
+{
+   if (!table) {
+      return NULL;
+   }
+
+   bool found = false;
+   size_t threads = 0;
+   for (size_t i = 0; i < table->nb_entries; ++i) {
+      const armbench_dispatch_entry_t *entry = table->entries + i;
+      if (entry->kind != kind) {
+         continue;
+      }
+      const bool fits = entry->nb_threads <= nb_threads;
+      const bool best_fits = threads <= nb_threads;
+      if (!found || (fits && (!best_fits || entry->nb_threads > threads)) ||
+          (!fits && !best_fits && entry->nb_threads < threads)) {
+         threads = entry->nb_threads;
+         found = true;
+      }
+   }
+
+   const armbench_dispatch_entry_t *match = NULL;
+   for (size_t i = 0; found && i < table->nb_entries; ++i) {
+      const armbench_dispatch_entry_t *entry = table->entries + i;
+      if (entry->kind != kind || entry->nb_threads != threads) {
+         continue;
+      }
+      if (!match || entry->min_bytes <= nb_bytes) {
+         match = entry;
+      }
+   }
+
+   return match ? armbench_find_kernel(bench, kind, match->name) : NULL;
+}
@@ -0,0 +1,45 @@
+#include "cache.h"
+
+#include <stddef.h>
+#include <stdint.h>
+
+#if defined(__x86_64__)
+   #include <immintrin.h>
+#endif
+
+#if defined(__aarch64__)
+// Smallest data cache line size, from `CTR_EL0.DminLine` (log2 of words).
+static inline size_t dcache_line_size(void)
+{
+   uint64_t ctr;
+   __asm__ volatile("mrs %0, ctr_el0" : "=r"(ctr));
+   return 4 << ((ctr >> 16) & 0xf);
+}
+#endif
+
+// Cleans and invalidates `[addr, addr + size)` from every cache level down
+// to the point of coherency, so that the next access is served from DRAM.
+int cache_flush(const void *addr, const size_t size)
+{
+#if defined(__aarch64__)
+   const size_t line = dcache_line_size();
+   uintptr_t ptr = (uintptr_t)addr & ~(uintptr_t)(line - 1);
+   for (; ptr < (uintptr_t)addr + size; ptr += line) {
+      __asm__ volatile("dc civac, %0" : : "r"(ptr) : "memory");
+   }
+   __asm__ volatile("dsb ish" : : : "memory");
+   return 0;
+#elif defined(__x86_64__)
+   const size_t line = 64;
+   uintptr_t ptr = (uintptr_t)addr & ~(uintptr_t)(line - 1);
+   for (; ptr < (uintptr_t)addr + size; ptr += line) {
+      _mm_clflush((const void *)ptr);
+   }
+   _mm_mfence();
+   return 0;
+#else
+   (void)addr;
+   (void)size;
+   return -1;
+#endif
+}
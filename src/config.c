@@ -1,9 +1,12 @@
-#include "config.h"
+#include "cli.h"
 
+#include "armbench.h"
 #include "consts.h"
 #include "logs.h"
+#include "utils.h"
 
 #include <getopt.h>
+#include <math.h>
 #include <stdbool.h>
 #include <stdio.h>
 #include <stdlib.h>
@@ -25,13 +28,71 @@ void print_help(const char *bin)
           "\n\033[1mOptions:\033[0m\n"
           "\t-s [SIZE]             Vector size in bytes (default: %dB).\n"
           "\t-r [NB_REP]           Number of repetitions (default: %d).\n"
+          "\t-c [CACHE_MODE]       Cache state at the start of each "
+          "repetition, one of:\n"
+          "\t                       - none: back-to-back repetitions "
+          "(default);\n"
+          "\t                       - hot: operands primed in cache;\n"
+          "\t                       - cold: operands flushed to memory;\n"
+          "\t                       - both: hot and cold.\n"
+          "\t-p [NB_PROCS]         Number of worker processes, each pinned "
+          "to its own core (default: %d).\n"
+          "\t-b [BG_LOAD]          Measures the kernel against a growing "
+          "number of background\n"
+          "\t                      threads running <BG_LOAD>, one of:\n"
+          "\t                       - copy: streaming copy;\n"
+          "\t                       - init: streaming store;\n"
+          "\t                       - random: random-access loads.\n"
+          "\t-t [NB_THREADS]       Maximum number of background threads "
+          "(default: %d).\n"
+          "\t-u [DUTY_CYCLE]       Percentage of time background threads "
+          "are busy (default: %d).\n"
+          "\t-d [DURATION]         Runs the kernel continuously for "
+          "<DURATION> (e.g. 30s, 10m, 1h)\n"
+          "\t                      and reports its throughput over time.\n"
+          "\t-I [INTERVAL]         Sampling interval of the `-d` time "
+          "series (default: %.0lfs).\n"
+          "\t-m [IMPL]             Implementation run by `-d`, either "
+          "`compiler` or `assembly`\n"
+          "\t                      (default: assembly).\n"
+          "\t-a [FILE]             Autotunes every variant of the kernel "
+          "(of all kernels without `-k`)\n"
+          "\t                      from %dB to <SIZE> bytes and 1 to "
+          "<NB_PROCS> processes,\n"
+          "\t                      and writes the resulting dispatch table "
+          "to <FILE>.\n"
+          "\t-A                    Measures the speed and accuracy of every "
+          "variant of `reduc`\n"
+          "\t                      or `dotprod` against an exact "
+          "reference.\n"
           "\t-e [ERROR_TOLERANCE]  Error tolerance (default: %e).\n"
           "\t-v                    Prints the version number.\n"
           "\t-h                    Prints this help.\n\n",
-          bin, DEFAULT_SIZE, DEFAULT_REP, DEFAULT_ERROR);
+          bin, DEFAULT_SIZE, DEFAULT_REP, DEFAULT_PROCS, DEFAULT_BG_THREADS,
+          DEFAULT_DUTY_CYCLE, DEFAULT_INTERVAL, AUTOTUNE_MIN_SIZE,
+          DEFAULT_ERROR);
 }
 
-char *bench_kind_to_string(const bench_kind_t kind)
+// Number of vectors streamed to or from memory by one call of the kernel.
+size_t bench_kind_nb_streams(const armbench_kind_t kind)
+{
+   switch (kind) {
+      case BENCH_KIND_INIT:
+      case BENCH_KIND_REDUC:
+         return 1;
+      case BENCH_KIND_COPY:
+      case BENCH_KIND_DOTPROD:
+      case BENCH_KIND_SCALE:
+         return 2;
+      case BENCH_KIND_GAXPY:
+      case BENCH_KIND_SUM:
+         return 3;
+      default:
+         return 0;
+   }
+}
+
+char *bench_kind_to_string(const armbench_kind_t kind)
 {
    switch (kind) {
       case BENCH_KIND_INIT:
@@ -53,12 +114,64 @@ char *bench_kind_to_string(const bench_kind_t kind)
    }
 }
 
-int config_init(config_t *config, int argc, char *argv[argc + 1])
+// Parses a duration such as `90`, `90s`, `10m` or `1h` into seconds.
+double parse_duration(const char *str)
+{
+   char *endptr;
+   const double value = strtod(str, &endptr);
+   if (endptr == str || value < 0.0) {
+      return 0.0;
+   }
+   if (!strcmp(endptr, "") || !strcmp(endptr, "s")) {
+      return value;
+   }
+   if (!strcmp(endptr, "m")) {
+      return value * 60.0;
+   }
+   if (!strcmp(endptr, "h")) {
+      return value * 3600.0;
+   }
+   return 0.0;
+}
+
+char *bg_load_to_string(const armbench_bg_load_t load)
+{
+   switch (load) {
+      case BG_LOAD_NONE:
+         return "none";
+      case BG_LOAD_COPY:
+         return "copy";
+      case BG_LOAD_INIT:
+         return "init";
+      case BG_LOAD_RANDOM:
+         return "random";
+      default:
+         return "???";
+   }
+}
+
+char *cache_mode_to_string(const armbench_cache_mode_t mode)
+{
+   switch (mode) {
+      case CACHE_MODE_NONE:
+         return "none";
+      case CACHE_MODE_HOT:
+         return "hot";
+      case CACHE_MODE_COLD:
+         return "cold";
+      case CACHE_MODE_BOTH:
+         return "both";
+      default:
+         return "???";
+   }
+}
+
+int config_init(armbench_config_t *config, int argc, char *argv[argc + 1])
 {
    bool is_kind_set = false;
 
    int opt;
-   while ((opt = getopt(argc, argv, "e:r:k:s:vh")) != -1) {
+   while ((opt = getopt(argc, argv, "a:Ab:c:d:e:I:m:p:r:k:s:t:u:vh")) != -1) {
       switch (opt) {
          case 'k': {
             if (!strcmp(optarg, "init")) {
@@ -119,6 +232,134 @@ int config_init(config_t *config, int argc, char *argv[argc + 1])
             }
             break;
          }
+         case 'c': {
+            if (!strcmp(optarg, "none")) {
+               config->cache_mode = CACHE_MODE_NONE;
+            }
+            else if (!strcmp(optarg, "hot")) {
+               config->cache_mode = CACHE_MODE_HOT;
+            }
+            else if (!strcmp(optarg, "cold")) {
+               config->cache_mode = CACHE_MODE_COLD;
+            }
+            else if (!strcmp(optarg, "both")) {
+               config->cache_mode = CACHE_MODE_BOTH;
+            }
+            else {
+               config->cache_mode = CACHE_MODE_NONE;
+               log_warn("unknown cache mode `%s`, "
+                        "using back-to-back repetitions.",
+                        optarg);
+            }
+            break;
+         }
+         case 'b': {
+            if (!strcmp(optarg, "copy")) {
+               config->bg_load = BG_LOAD_COPY;
+            }
+            else if (!strcmp(optarg, "init")) {
+               config->bg_load = BG_LOAD_INIT;
+            }
+            else if (!strcmp(optarg, "random")) {
+               config->bg_load = BG_LOAD_RANDOM;
+            }
+            else {
+               log_error("unknown background load `%s`. "
+                         "See help for available loads.",
+                         optarg);
+               exit(EXIT_FAILURE);
+            }
+            break;
+         }
+         case 't': {
+            char *endptr;
+            size_t threads = strtoul(optarg, &endptr, INTEGER_BASE);
+            if (threads) {
+               config->nb_bg_threads = threads;
+            }
+            else {
+               config->nb_bg_threads = DEFAULT_BG_THREADS;
+               log_warn("unable to parse `%s`, "
+                        "using default number of background threads (%zu).",
+                        optarg, DEFAULT_BG_THREADS);
+            }
+            break;
+         }
+         case 'u': {
+            char *endptr;
+            size_t duty_cycle = strtoul(optarg, &endptr, INTEGER_BASE);
+            if (duty_cycle && duty_cycle <= 100) {
+               config->bg_duty_cycle = duty_cycle;
+            }
+            else {
+               config->bg_duty_cycle = DEFAULT_DUTY_CYCLE;
+               log_warn("unable to parse `%s`, "
+                        "using default duty cycle (%zu%%).",
+                        optarg, DEFAULT_DUTY_CYCLE);
+            }
+            break;
+         }
+         case 'd': {
+            const double duration = parse_duration(optarg);
+            if (duration) {
+               config->soak_duration = duration;
+            }
+            else {
+               log_error("unable to parse duration `%s`.", optarg);
+               exit(EXIT_FAILURE);
+            }
+            break;
+         }
+         case 'I': {
+            const double interval = parse_duration(optarg);
+            if (interval) {
+               config->soak_interval = interval;
+            }
+            else {
+               config->soak_interval = DEFAULT_INTERVAL;
+               log_warn("unable to parse `%s`, "
+                        "using default sampling interval (%.0lfs).",
+                        optarg, DEFAULT_INTERVAL);
+            }
+            break;
+         }
+         case 'a': {
+            config->dispatch_path = optarg;
+            break;
+         }
+         case 'A': {
+            config->accuracy = true;
+            break;
+         }
+         case 'm': {
+            if (!strcmp(optarg, "compiler")) {
+               config->impl_kind = IMPL_KIND_COMPILER;
+            }
+            else if (!strcmp(optarg, "assembly")) {
+               config->impl_kind = IMPL_KIND_ASSEMBLY;
+            }
+            else {
+               log_error("unknown implementation `%s`. "
+                         "See help for available implementations.",
+                         optarg);
+               exit(EXIT_FAILURE);
+            }
+            break;
+         }
+         case 'p': {
+            char *endptr;
+            size_t procs = strtoul(optarg, &endptr, INTEGER_BASE);
+            if (procs) {
+               config->nb_procs = procs;
+            }
+            else {
+               config->nb_procs = DEFAULT_PROCS;
+               log_warn("unable to parse `%s`, "
+                        "using default number of processes (%zu).",
+                        optarg, DEFAULT_PROCS);
+            }
+            break;
+         }
          case 'e': {
             char *endptr;
             double error = strtod(optarg, &endptr);
@@ -138,7 +379,7 @@ int config_init(config_t *config, int argc, char *argv[argc + 1])
             exit(EXIT_SUCCESS);
          }
          case 'v': {
-            printf("\033[1mMini Arm SVE benchmarks - v0.2\n");
+            printf("\033[1mMini Arm SVE benchmarks - v" ARMBENCH_VERSION "\n");
             exit(EXIT_SUCCESS);
          }
          default: {
@@ -149,15 +390,42 @@ int config_init(config_t *config, int argc, char *argv[argc + 1])
       }
    }
 
-   if (!is_kind_set) {
+   if (!is_kind_set && !config->dispatch_path) {
       log_error(
          "benchmark kind needs to be set. See help for available benchmarks.");
       exit(EXIT_FAILURE);
    }
+   if (config->bg_load != BG_LOAD_NONE && config->nb_procs > 1) {
+      log_error("background load cannot be combined with multiple processes.");
+      exit(EXIT_FAILURE);
+   }
+   if (config->soak_duration > 0.0 &&
+       (config->bg_load != BG_LOAD_NONE || config->nb_procs > 1)) {
+      log_error("duration-based runs cannot be combined with background load "
+                "or multiple processes.");
+      exit(EXIT_FAILURE);
+   }
+   if (config->dispatch_path &&
+       (config->bg_load != BG_LOAD_NONE || config->soak_duration > 0.0)) {
+      log_error("autotuning cannot be combined with background load or "
+                "duration-based runs.");
+      exit(EXIT_FAILURE);
+   }
+   if (config->accuracy && config->benchmark_kind != BENCH_KIND_REDUC &&
+       config->benchmark_kind != BENCH_KIND_DOTPROD) {
+      log_error("accuracy mode only applies to `reduc` and `dotprod`.");
+      exit(EXIT_FAILURE);
+   }
+   if (config->accuracy &&
+       (config->nb_procs > 1 || config->bg_load != BG_LOAD_NONE ||
+        config->soak_duration > 0.0 || config->dispatch_path)) {
+      log_error("accuracy mode cannot be combined with other modes.");
+      exit(EXIT_FAILURE);
+   }
    return 0;
 }
 
-int config_print(const config_t *config)
+int config_print(const armbench_config_t *config)
 {
    float readable_size = config->nb_bytes;
    char *readable_unit = "B";
@@ -175,23 +443,295 @@ int config_print(const config_t *config)
    }
 
    char *bench_kind = bench_kind_to_string(config->benchmark_kind);
-   log_info("running `%s` benchmark with vectors of size %.2lf %s, "
-            "%zu repetitions and error tolerance of %.0e.",
-            bench_kind, readable_size, readable_unit, config->nb_repetitions,
-            config->error_tolerance);
+   if (config->dispatch_path) {
+      log_info("autotuning `%s` from %d B to %.2lf %s on 1 to %zu processes, "
+               "%zu repetitions and error tolerance of %.0e.",
+               config->benchmark_kind == BENCH_KIND__MAX ? "all" : bench_kind,
+               AUTOTUNE_MIN_SIZE, readable_size, readable_unit,
+               config->nb_procs, config->nb_repetitions,
+               config->error_tolerance);
+   }
+   else {
+      log_info("running `%s` benchmark with vectors of size %.2lf %s, "
+               "%zu repetitions and error tolerance of %.0e.",
+               bench_kind, readable_size, readable_unit,
+               config->nb_repetitions, config->error_tolerance);
+   }
+   if (config->cache_mode != CACHE_MODE_NONE) {
+      log_info("using `%s` cache mode.",
+               cache_mode_to_string(config->cache_mode));
+   }
+   if (config->nb_procs > 1 && !config->dispatch_path) {
+      log_info("running on %zu processes pinned to distinct cores.",
+               config->nb_procs);
+   }
+   if (config->soak_duration > 0.0) {
+      log_info("running `%s` implementation for %.0lfs, sampling every %.3lfs.",
+               config->impl_kind == IMPL_KIND_COMPILER ? "compiler"
+                                                       : "assembly",
+               config->soak_duration, config->soak_interval);
+   }
+   if (config->accuracy) {
+      log_info("measuring every `%s` variant against an exact reference.",
+               bench_kind);
+   }
+   if (config->bg_load != BG_LOAD_NONE) {
+      log_info("running against up to %zu `%s` background threads "
+               "busy %zu%% of the time.",
+               config->nb_bg_threads, bg_load_to_string(config->bg_load),
+               config->bg_duty_cycle);
+   }
    return 0;
 }
 
-int config_result(const config_t *config)
+void print_insn_mix(const char *name, const armbench_insn_mix_t *mix)
+{
+   if (!mix->available) {
+      printf("  %s hot loop: n/a\n", name);
+      return;
+   }
+   printf("  %s hot loop: %zu insns (SVE: %zu, NEON: %zu, scalar: %zu), "
+          "%zu loads, %zu stores, %zu FMAs, %zu gathers/scatters "
+          "[function: %zu insns]\n",
+          name, mix->loop_insns, mix->nb_sve, mix->nb_neon, mix->nb_scalar,
+          mix->nb_loads, mix->nb_stores, mix->nb_fmas, mix->nb_gathers,
+          mix->function_insns);
+}
+
+void print_stats(const char *name, const char *unit, const double *samples,
+                 const size_t len)
+{
+   const stats_t stats = compute_stats(samples, len);
+   printf("  %s: min %.3lf%s, mean %.3lf%s, max %.3lf%s, stddev %.3lf%s\n",
+          name, stats.min, unit, stats.mean, unit, stats.max, unit,
+          stats.stddev, unit);
+}
+
+void print_proc_results(const armbench_config_t *config)
+{
+   const size_t nb_procs = config->nb_procs;
+   const size_t nb_streams = bench_kind_nb_streams(config->benchmark_kind);
+   const double nb_bytes = (double)(config->nb_bytes * nb_streams);
+   double compiler_latency[nb_procs], assembly_latency[nb_procs];
+   double compiler_bandwidth[nb_procs], assembly_bandwidth[nb_procs];
+   double compiler_total = 0.0, assembly_total = 0.0;
+
+   printf("Per-process results:\n"
+          "  %6s %5s %15s %15s %14s %14s\n",
+          "RANK", "CPU", "COMPILER (µs)", "ASSEMBLY (µs)", "COMPILER GB/s",
+          "ASSEMBLY GB/s");
+   for (size_t i = 0; i < nb_procs; ++i) {
+      const armbench_proc_result_t *result = config->proc_results + i;
+      compiler_latency[i] = result->config.compiler_latency;
+      assembly_latency[i] = result->config.assembly_latency;
+      compiler_bandwidth[i] = nb_bytes / compiler_latency[i] / 1e3;
+      assembly_bandwidth[i] = nb_bytes / assembly_latency[i] / 1e3;
+      compiler_total += compiler_bandwidth[i];
+      assembly_total += assembly_bandwidth[i];
+      printf("  %6zu %5d %14.3lf %14.3lf %14.3lf %14.3lf\n", i, result->cpu,
+             compiler_latency[i], assembly_latency[i], compiler_bandwidth[i],
+             assembly_bandwidth[i]);
+   }
+
+   printf("Per-process distribution:\n");
+   print_stats("Compiler latency", "µs", compiler_latency, nb_procs);
+   print_stats("Assembly latency", "µs", assembly_latency, nb_procs);
+   print_stats("Compiler bandwidth", "GB/s", compiler_bandwidth, nb_procs);
+   print_stats("Assembly bandwidth", "GB/s", assembly_bandwidth, nb_procs);
+   printf("Node bandwidth:\n"
+          "  Compiler: %.3lfGB/s\n"
+          "  Assembly: %.3lfGB/s\n",
+          compiler_total, assembly_total);
+}
+
+void print_interference_results(const armbench_config_t *config)
+{
+   const size_t nb_streams = bench_kind_nb_streams(config->benchmark_kind);
+   const double nb_bytes = (double)(config->nb_bytes * nb_streams);
+   const armbench_interference_result_t *isolated =
+      config->interference_results;
+
+   printf("Interference results:\n"
+          "  %7s %13s %15s %15s %14s %14s %15s %15s\n",
+          "THREADS", "BG GB/s", "COMPILER (µs)", "ASSEMBLY (µs)",
+          "COMPILER GB/s", "ASSEMBLY GB/s", "COMPILER SLOWER",
+          "ASSEMBLY SLOWER");
+   for (size_t i = 0; i <= config->nb_bg_threads; ++i) {
+      const armbench_interference_result_t *result =
+         config->interference_results + i;
+      printf("  %7zu %13.3lf %14.3lf %14.3lf %14.3lf %14.3lf %14.3lfx "
+             "%14.3lfx\n",
+             result->nb_threads, result->background_bandwidth,
+             result->compiler_latency, result->assembly_latency,
+             nb_bytes / result->compiler_latency / 1e3,
+             nb_bytes / result->assembly_latency / 1e3,
+             result->compiler_latency / isolated->compiler_latency,
+             result->assembly_latency / isolated->assembly_latency);
+   }
+}
+
+void print_soak_results(const armbench_config_t *config)
 {
+   const size_t nb_streams = bench_kind_nb_streams(config->benchmark_kind);
+   const double nb_bytes = (double)(config->nb_bytes * nb_streams);
+   const size_t nb_samples = config->nb_soak_samples;
+   if (!nb_samples) {
+      printf("\033[1;31m`%s` soak produced no sample.\033[0m\n",
+             bench_kind_to_string(config->benchmark_kind));
+      return;
+   }
+
+   double throughput[nb_samples];
+   printf("\033[1m`%s` soak time series:\033[0m\n"
+          "  %10s %14s %15s %15s %11s\n",
+          bench_kind_to_string(config->benchmark_kind), "TIME (s)", "GB/s",
+          "LATENCY (µs)", "FREQ (MHz)", "TEMP (°C)");
+   for (size_t i = 0; i < nb_samples; ++i) {
+      const armbench_soak_sample_t *sample = config->soak_samples + i;
+      throughput[i] = (double)(sample->nb_calls) * nb_bytes / sample->elapsed;
+      printf("  %10.3lf %14.3lf %14.3lf", sample->timestamp, throughput[i],
+             sample->elapsed / (double)(sample->nb_calls) / 1e3);
+      if (sample->frequency <= 0.0) {
+         printf(" %15s", "n/a");
+      }
+      else {
+         printf(" %15.0lf", sample->frequency);
+      }
+      if (sample->temperature <= 0.0) {
+         printf(" %10s\n", "n/a");
+      }
+      else {
+         printf(" %10.1lf\n", sample->temperature);
+      }
+   }
+   if (config->nb_soak_dropped) {
+      log_warn("%zu samples were dropped by the reporter.",
+               config->nb_soak_dropped);
+   }
+
+   // Burst is the first interval, sustained is the second half of the run
+   const double burst = throughput[0];
+   const stats_t sustained =
+      compute_stats(throughput + nb_samples / 2, nb_samples - nb_samples / 2);
+   const double delta = (sustained.mean - burst) / burst;
+   printf("  Burst throughput:     %.3lfGB/s\n"
+          "  Sustained throughput: %.3lfGB/s (stddev %.3lfGB/s)\n"
+          "  Sustained vs. burst:  %+.2lf%%\n",
+          burst, sustained.mean, sustained.stddev, delta * 100.0);
+   if (fabs(delta) > SOAK_DRIFT_THRESHOLD) {
+      log_warn("sustained throughput drifted by more than %.0lf%% from "
+               "burst, check for thermal or frequency throttling.",
+               SOAK_DRIFT_THRESHOLD * 100.0);
+   }
+}
+
+void print_dispatch_table(const armbench_config_t *config)
+{
+   const armbench_dispatch_table_t *table = config->dispatch_table;
+   printf("\033[1mDispatch table (written to `%s`):\033[0m\n"
+          "  %-10s %7s %14s %14s  %s\n",
+          config->dispatch_path, "KERNEL", "THREADS", "MIN SIZE (B)",
+          "MAX SIZE (B)", "VARIANT");
+   for (size_t i = 0; i < table->nb_entries; ++i) {
+      const armbench_dispatch_entry_t *entry = table->entries + i;
+      printf("  %-10s %7zu %14zu %14zu  %s\n",
+             bench_kind_to_string(entry->kind), entry->nb_threads,
+             entry->min_bytes, entry->max_bytes, entry->name);
+   }
+   if (!config->passed) {
+      log_warn("no variant passed the error tolerance at some sizes, "
+               "they are missing from the table.");
+   }
+}
+
+void print_accuracy_results(const armbench_config_t *config)
+{
+   const size_t len = config->nb_bytes / sizeof(double);
+   const armbench_accuracy_result_t *cheapest = NULL;
+
+   printf("\033[1m`%s` accuracy vs. speed (exact result: %.17g):\033[0m\n"
+          "  %-12s %14s %10s %12s %12s %6s\n",
+          bench_kind_to_string(config->benchmark_kind),
+          config->nb_accuracy_results ? config->accuracy_results->exact : 0.0,
+          "VARIANT", "LATENCY (µs)", "NS/ELEM", "CYCLES/ELEM", "REL. ERROR",
+          "BITS");
+   for (size_t i = 0; i < config->nb_accuracy_results; ++i) {
+      const armbench_accuracy_result_t *result = config->accuracy_results + i;
+      printf("  %-12s %13.3lf %10.4lf", result->name, result->latency,
+             result->latency * 1e3 / (double)(len));
+      if (result->cycles_per_element <= 0.0) {
+         printf(" %12s", "n/a");
+      }
+      else {
+         printf(" %12.4lf", result->cycles_per_element);
+      }
+      printf(" %12.3e %6.1lf\n", result->error, result->bits);
+
+      if (result->error <= config->error_tolerance &&
+          (!cheapest || result->latency < cheapest->latency)) {
+         cheapest = result;
+      }
+   }
+
+   if (cheapest) {
+      printf("Cheapest variant within %.0e: `%s`\n", config->error_tolerance,
+             cheapest->name);
+   }
+   else {
+      log_warn("no variant is within the error tolerance of %.0e.",
+               config->error_tolerance);
+   }
+}
+
+int config_result(const armbench_config_t *config)
+{
+   if (config->accuracy_results) {
+      print_accuracy_results(config);
+      return 0;
+   }
+   if (config->dispatch_table) {
+      print_dispatch_table(config);
+      return 0;
+   }
+   if (config->soak_samples) {
+      if (!config->passed) {
+         log_warn("implementations disagree before the soak (error %.0e "
+                  "above tolerance %.0e).",
+                  config->computed_error, config->error_tolerance);
+      }
+      print_soak_results(config);
+      printf("Instruction mix (per loop iteration):\n");
+      print_insn_mix(config->impl_kind == IMPL_KIND_COMPILER ? "Compiler"
+                                                             : "Assembly",
+                     config->impl_kind == IMPL_KIND_COMPILER
+                        ? &config->compiler_mix
+                        : &config->assembly_mix);
+      return 0;
+   }
+
    if (config->passed) {
+      const char *state = "";
+      if (config->cache_mode == CACHE_MODE_HOT ||
+          config->cache_mode == CACHE_MODE_BOTH) {
+         state = " (hot)";
+      }
+      else if (config->cache_mode == CACHE_MODE_COLD) {
+         state = " (cold)";
+      }
       printf("\033[1;32m`%s` benchmark passed!\033[0m\n"
-             "  Compiler latency: %.3lfµs\n"
-             "  Assembly latency: %.3lfµs\n"
-             "Hand-written assembly speedup: %.3lfx\n",
-             bench_kind_to_string(config->benchmark_kind),
-             config->compiler_latency, config->assembly_latency,
+             "  Compiler latency%s: %.3lfµs\n"
+             "  Assembly latency%s: %.3lfµs\n"
+             "Hand-written assembly speedup%s: %.3lfx\n",
+             bench_kind_to_string(config->benchmark_kind), state,
+             config->compiler_latency, state, config->assembly_latency, state,
              config->speedup);
+      if (config->cache_mode == CACHE_MODE_BOTH) {
+         printf("  Compiler latency (cold): %.3lfµs\n"
+                "  Assembly latency (cold): %.3lfµs\n"
+                "Hand-written assembly speedup (cold): %.3lfx\n",
+                config->compiler_cold_latency, config->assembly_cold_latency,
+                config->cold_speedup);
+      }
    }
    else {
       printf("\033[1;31m`%s` benchmark failed.\033[0m\n"
@@ -200,5 +740,16 @@ int config_result(const config_t *config)
              bench_kind_to_string(config->benchmark_kind),
              config->error_tolerance, config->computed_error);
    }
+
+   if (config->proc_results) {
+      print_proc_results(config);
+   }
+   if (config->interference_results) {
+      print_interference_results(config);
+   }
+
+   printf("Instruction mix (per loop iteration):\n");
+   print_insn_mix("Compiler", &config->compiler_mix);
+   print_insn_mix("Assembly", &config->assembly_mix);
    return 0;
 }
@@ -1,48 +1,108 @@
 #include "drivers.h"
 
-#include "config.h"
+#include "armbench.h"
+#include "cache.h"
 #include "consts.h"
+#include "insn_mix.h"
 #include "kernels.h"
-#include "logs.h"
+#include "multiproc.h"
+#include "soak.h"
 #include "utils.h"
 
-#include <math.h>
 #include <stdbool.h>
+#include <stdint.h>
 #include <stdlib.h>
 #include <time.h>
 
+typedef enum operand_e {
+   OPERAND_X,
+   OPERAND_Y,
+   OPERAND_R,
+} operand_t;
+
+// How a soak undoes an in-place kernel, so that its operands do not drift
+// towards zero, subnormals or infinities over the run.
+typedef enum soak_undo_e {
+   SOAK_UNDO_NONE,
+   SOAK_UNDO_NEGATE_K,
+   SOAK_UNDO_INVERT_K,
+   SOAK_UNDO_NEGATE_Y,
+} soak_undo_t;
+
+/**
+ * Operands needed by a benchmark kind, and the one holding the output that
+ * is compared between both implementations.
+ **/
+typedef struct kind_desc_s {
+   bool random_x;
+   bool has_y;
+   bool has_k;
+   bool has_r;
+   operand_t output;
+   soak_undo_t soak_undo;
+} kind_desc_t;
+
+static const kind_desc_t kind_descs[BENCH_KIND__MAX] = {
+   [BENCH_KIND_INIT] = { .has_k = true, .output = OPERAND_X },
+   [BENCH_KIND_COPY] = { .has_y = true, .output = OPERAND_X },
+   [BENCH_KIND_REDUC] = { .random_x = true,
+                          .has_r = true,
+                          .output = OPERAND_R },
+   [BENCH_KIND_DOTPROD] = { .random_x = true,
+                            .has_y = true,
+                            .has_r = true,
+                            .output = OPERAND_R },
+   [BENCH_KIND_GAXPY] = { .random_x = true,
+                          .has_y = true,
+                          .has_k = true,
+                          .output = OPERAND_Y,
+                          .soak_undo = SOAK_UNDO_NEGATE_K },
+   [BENCH_KIND_SUM] = { .random_x = true,
+                        .has_y = true,
+                        .output = OPERAND_X,
+                        .soak_undo = SOAK_UNDO_NEGATE_Y },
+   [BENCH_KIND_SCALE] = { .random_x = true,
+                          .has_k = true,
+                          .output = OPERAND_X,
+                          .soak_undo = SOAK_UNDO_INVERT_K },
+};
+
 typedef struct vectors_s {
    double *compiler_vec;
    double *assembly_vec;
    size_t len;
 } vectors_t;
 
-vectors_t init_vectors(const size_t size, const bool mode)
+typedef struct buffers_s {
+   vectors_t x;
+   vectors_t y;
+   vectors_t r;
+} buffers_t;
+
+static int init_vectors(vectors_t *vecs, const size_t len, const bool mode,
+                        const uint64_t seed)
 {
-   srand(0);
-   vectors_t vecs = {
-      .compiler_vec = aligned_alloc(ALIGNMENT, size),
-      .assembly_vec = aligned_alloc(ALIGNMENT, size),
-      .len = size / sizeof(double),
-   };
-   if (!vecs.compiler_vec || !vecs.assembly_vec) {
-      log_error("failed to allocate vectors.\n");
-      exit(EXIT_FAILURE);
+   uint64_t state = seed;
+   vecs->compiler_vec = aligned_alloc(ALIGNMENT, len * sizeof(double));
+   vecs->assembly_vec = aligned_alloc(ALIGNMENT, len * sizeof(double));
+   vecs->len = len;
+   if (!vecs->compiler_vec || !vecs->assembly_vec) {
+      return ARMBENCH_ERROR_ALLOC;
    }
 
    double rand_val = 0.0;
-   for (size_t i = 0; i < vecs.len; ++i) {
+   for (size_t i = 0; i < vecs->len; ++i) {
       if (mode) {
-         rand_val = rand_double(-1.0, 1.0);
+         rand_val = rand_double(&state, -1.0, 1.0);
       }
-      vecs.compiler_vec[i] = rand_val;
-      vecs.assembly_vec[i] = rand_val;
+      vecs->compiler_vec[i] = rand_val;
+      vecs->assembly_vec[i] = rand_val;
    }
 
-   return vecs;
+   return ARMBENCH_SUCCESS;
 }
 
-void destroy_vectors(vectors_t *vecs)
+static void destroy_vectors(vectors_t *vecs)
 {
    if (!vecs) {
       return;
@@ -51,278 +111,257 @@ void destroy_vectors(vectors_t *vecs)
    free(vecs->assembly_vec);
 }
 
-int driver_init(config_t *config)
+static int init_buffers(buffers_t *bufs, const kind_desc_t *desc,
+                        const armbench_config_t *config)
 {
-   vectors_t x = init_vectors(config->nb_bytes, false);
-   const double k = rand_double(-1.0, 1.0);
-   struct timespec start, end;
-
-   // Run compiler benchmark
-   clock_gettime(CLOCK_MONOTONIC_RAW, &start);
-   for (size_t i = 0; i < config->nb_repetitions; ++i) {
-      compiler_init(k, x.compiler_vec, x.len);
+   const size_t len = config->nb_bytes / sizeof(double);
+   int ret = init_vectors(&bufs->x, len, desc->random_x, config->seed);
+   if (!ret && desc->has_y) {
+      ret = init_vectors(&bufs->y, len, true, config->seed);
    }
-   clock_gettime(CLOCK_MONOTONIC_RAW, &end);
-   config->compiler_latency =
-      compute_avg_latency(start, end, config->nb_repetitions);
-
-   // Run assembly benchmark
-   clock_gettime(CLOCK_MONOTONIC_RAW, &start);
-   for (size_t i = 0; i < config->nb_repetitions; ++i) {
-      assembly_init(k, x.assembly_vec, x.len);
+   if (!ret && desc->has_r) {
+      ret = init_vectors(&bufs->r, config->nb_repetitions, false, 0);
    }
-   clock_gettime(CLOCK_MONOTONIC_RAW, &end);
-   config->assembly_latency =
-      compute_avg_latency(start, end, config->nb_repetitions);
+   return ret;
+}
 
-   // Compute speedup
-   config->speedup = config->compiler_latency / config->assembly_latency;
+static void destroy_buffers(buffers_t *bufs)
+{
+   destroy_vectors(&bufs->x);
+   destroy_vectors(&bufs->y);
+   destroy_vectors(&bufs->r);
+}
 
-   // Compute error
-   config->computed_error =
-      compute_error(x.compiler_vec, x.assembly_vec, x.len);
-   if (config->computed_error <= config->error_tolerance) {
-      config->passed = true;
+// Lines up the worker processes right before a timed section.
+static inline void bench_sync(const run_context_t *context)
+{
+   if (context->barrier) {
+      shm_barrier_wait(context->barrier);
    }
-
-   destroy_vectors(&x);
-   return 0;
 }
 
-int driver_copy(config_t *config)
+static inline void bench_section(const run_context_t *context,
+                                 const bool begin)
 {
-   vectors_t x = init_vectors(config->nb_bytes, false);
-   vectors_t y = init_vectors(config->nb_bytes, true);
-   struct timespec start, end;
-
-   // Run compiler benchmark
-   clock_gettime(CLOCK_MONOTONIC_RAW, &start);
-   for (size_t i = 0; i < config->nb_repetitions; ++i) {
-      compiler_copy(x.compiler_vec, y.compiler_vec, x.len);
+   if (context->section_hook) {
+      context->section_hook(context->section_data, begin);
    }
-   clock_gettime(CLOCK_MONOTONIC_RAW, &end);
-   config->compiler_latency =
-      compute_avg_latency(start, end, config->nb_repetitions);
+}
 
-   // Run assembly benchmark
-   clock_gettime(CLOCK_MONOTONIC_RAW, &start);
-   for (size_t i = 0; i < config->nb_repetitions; ++i) {
-      assembly_copy(x.assembly_vec, y.assembly_vec, x.len);
+static int flush_args(const armbench_args_t *args)
+{
+   int ret = 0;
+   if (args->x) {
+      ret |= cache_flush(args->x, args->len * sizeof(double));
    }
-   clock_gettime(CLOCK_MONOTONIC_RAW, &end);
-   config->assembly_latency =
-      compute_avg_latency(start, end, config->nb_repetitions);
-
-   // Compute speedup
-   config->speedup = config->compiler_latency / config->assembly_latency;
-
-   // Compute error
-   config->computed_error =
-      compute_error(x.compiler_vec, x.assembly_vec, x.len);
-   if (config->computed_error <= config->error_tolerance) {
-      config->passed = true;
+   if (args->y) {
+      ret |= cache_flush(args->y, args->len * sizeof(double));
    }
-
-   destroy_vectors(&x);
-   destroy_vectors(&y);
-   return 0;
+   return ret ? ARMBENCH_ERROR_UNSUPPORTED : ARMBENCH_SUCCESS;
 }
 
-int driver_reduc(config_t *config)
+/**
+ * Returns the average latency of one call, in microseconds.
+ *
+ * In the hot state, the kernel is called once before the timed section so
+ * that every repetition finds its operands in cache. In the cold state, the
+ * operands are flushed before each repetition and only the kernel call is
+ * timed.
+ **/
+static double time_kernel(const armbench_config_t *config,
+                          const run_context_t *context,
+                          const armbench_cache_mode_t mode,
+                          const armbench_call_t call,
+                          const armbench_args_t *args)
 {
-   vectors_t x = init_vectors(config->nb_bytes, true);
-   double compiler_results[config->nb_repetitions];
-   double assembly_results[config->nb_repetitions];
+   const size_t nb_repetitions = config->nb_repetitions;
    struct timespec start, end;
 
-   // Run compiler benchmark
-   clock_gettime(CLOCK_MONOTONIC_RAW, &start);
-   for (size_t i = 0; i < config->nb_repetitions; ++i) {
-      compiler_reduc(x.compiler_vec, compiler_results + i, x.len);
+   if (mode == CACHE_MODE_COLD) {
+      double latency = 0.0;
+      bench_sync(context);
+      for (size_t i = 0; i < nb_repetitions; ++i) {
+         flush_args(args);
+         // Flushes are not part of the timed section
+         bench_section(context, true);
+         clock_gettime(CLOCK_MONOTONIC_RAW, &start);
+         call(args, i);
+         clock_gettime(CLOCK_MONOTONIC_RAW, &end);
+         bench_section(context, false);
+         latency += compute_avg_latency(start, end, 1);
+      }
+      return latency / (double)(nb_repetitions);
    }
-   clock_gettime(CLOCK_MONOTONIC_RAW, &end);
-   config->compiler_latency =
-      compute_avg_latency(start, end, config->nb_repetitions);
 
-   // Run assembly benchmark
+   if (mode == CACHE_MODE_HOT) {
+      call(args, 0);
+   }
+   bench_sync(context);
+   bench_section(context, true);
    clock_gettime(CLOCK_MONOTONIC_RAW, &start);
-   for (size_t i = 0; i < config->nb_repetitions; ++i) {
-      assembly_reduc(x.assembly_vec, assembly_results + i, x.len);
+   for (size_t i = 0; i < nb_repetitions; ++i) {
+      call(args, i);
    }
    clock_gettime(CLOCK_MONOTONIC_RAW, &end);
-   config->assembly_latency =
-      compute_avg_latency(start, end, config->nb_repetitions);
-
-   // Compute speedup
-   config->speedup = config->compiler_latency / config->assembly_latency;
-
-   // Compute error
-   config->computed_error =
-      compute_error(compiler_results, assembly_results, config->nb_repetitions);
-   if (config->computed_error <= config->error_tolerance) {
-      config->passed = true;
-   }
-
-   destroy_vectors(&x);
-   return 0;
+   bench_section(context, false);
+   return compute_avg_latency(start, end, nb_repetitions);
 }
 
-int driver_dotprod(config_t *config)
+static int run_benchmark(armbench_config_t *config,
+                         const run_context_t *context,
+                         const armbench_call_t compiler_call,
+                         const armbench_args_t *compiler_args,
+                         const armbench_call_t assembly_call,
+                         const armbench_args_t *assembly_args)
 {
-   vectors_t x = init_vectors(config->nb_bytes, true);
-   vectors_t y = init_vectors(config->nb_bytes, true);
-   double compiler_results[config->nb_repetitions];
-   double assembly_results[config->nb_repetitions];
-   struct timespec start, end;
+   // Cold numbers are meaningless if the operands cannot be flushed
+   if ((config->cache_mode == CACHE_MODE_COLD ||
+        config->cache_mode == CACHE_MODE_BOTH) &&
+       (flush_args(compiler_args) || flush_args(assembly_args))) {
+      return ARMBENCH_ERROR_UNSUPPORTED;
+   }
+
+   const armbench_cache_mode_t mode =
+      config->cache_mode == CACHE_MODE_BOTH ? CACHE_MODE_HOT
+                                            : config->cache_mode;
 
    // Run compiler benchmark
-   clock_gettime(CLOCK_MONOTONIC_RAW, &start);
-   for (size_t i = 0; i < config->nb_repetitions; ++i) {
-      compiler_dotprod(x.compiler_vec, y.compiler_vec, compiler_results + i,
-                       x.len);
-   }
-   clock_gettime(CLOCK_MONOTONIC_RAW, &end);
    config->compiler_latency =
-      compute_avg_latency(start, end, config->nb_repetitions);
+      time_kernel(config, context, mode, compiler_call, compiler_args);
 
    // Run assembly benchmark
-   clock_gettime(CLOCK_MONOTONIC_RAW, &start);
-   for (size_t i = 0; i < config->nb_repetitions; ++i) {
-      assembly_dotprod(x.assembly_vec, y.assembly_vec, assembly_results + i,
-                       y.len);
-   }
-   clock_gettime(CLOCK_MONOTONIC_RAW, &end);
    config->assembly_latency =
-      compute_avg_latency(start, end, config->nb_repetitions);
+      time_kernel(config, context, mode, assembly_call, assembly_args);
 
    // Compute speedup
    config->speedup = config->compiler_latency / config->assembly_latency;
 
-   // Compute error
-   config->computed_error =
-      compute_error(compiler_results, assembly_results, config->nb_repetitions);
-   if (config->computed_error <= config->error_tolerance) {
-      config->passed = true;
+   if (config->cache_mode != CACHE_MODE_BOTH) {
+      return ARMBENCH_SUCCESS;
    }
 
-   destroy_vectors(&x);
-   destroy_vectors(&y);
-   return 0;
+   // Run cold-cache benchmarks
+   config->compiler_cold_latency = time_kernel(
+      config, context, CACHE_MODE_COLD, compiler_call, compiler_args);
+   config->assembly_cold_latency = time_kernel(
+      config, context, CACHE_MODE_COLD, assembly_call, assembly_args);
+   config->cold_speedup =
+      config->compiler_cold_latency / config->assembly_cold_latency;
+   return ARMBENCH_SUCCESS;
 }
 
-int driver_gaxpy(config_t *config)
+/**
+ * Soaks `call`, alternating it with the call that undoes it so that in-place
+ * kernels keep working on the same values for the whole run.
+ **/
+static int soak_benchmark(armbench_config_t *config, const kind_desc_t *desc,
+                          const armbench_call_t call,
+                          const armbench_args_t *args)
 {
-   vectors_t x = init_vectors(config->nb_bytes, true);
-   vectors_t y = init_vectors(config->nb_bytes, true);
-   const double a = rand_double(-1.0, 1.0);
-   struct timespec start, end;
-
-   // Run compiler benchmark
-   clock_gettime(CLOCK_MONOTONIC_RAW, &start);
-   for (size_t i = 0; i < config->nb_repetitions; ++i) {
-      compiler_gaxpy(a, x.compiler_vec, y.compiler_vec, y.len);
+   armbench_args_t pair[2] = { *args, *args };
+   double *negated_y = NULL;
+   switch (desc->soak_undo) {
+      case SOAK_UNDO_NEGATE_K:
+         pair[1].k = -args->k;
+         break;
+      case SOAK_UNDO_INVERT_K:
+         pair[1].k = 1.0 / args->k;
+         break;
+      case SOAK_UNDO_NEGATE_Y:
+         negated_y = aligned_alloc(ALIGNMENT, args->len * sizeof(double));
+         if (!negated_y) {
+            return ARMBENCH_ERROR_ALLOC;
+         }
+         for (size_t i = 0; i < args->len; ++i) {
+            negated_y[i] = -args->y[i];
+         }
+         pair[1].y = negated_y;
+         break;
+      default:
+         break;
    }
-   clock_gettime(CLOCK_MONOTONIC_RAW, &end);
-   config->compiler_latency =
-      compute_avg_latency(start, end, config->nb_repetitions);
 
-   // Run assembly benchmark
-   clock_gettime(CLOCK_MONOTONIC_RAW, &start);
-   for (size_t i = 0; i < config->nb_repetitions; ++i) {
-      assembly_gaxpy(a, x.assembly_vec, y.assembly_vec, y.len);
-   }
-   clock_gettime(CLOCK_MONOTONIC_RAW, &end);
-   config->assembly_latency =
-      compute_avg_latency(start, end, config->nb_repetitions);
-
-   // Compute speedup
-   config->speedup = config->compiler_latency / config->assembly_latency;
+   const int ret = soak_run(config, call, pair);
+   free(negated_y);
+   return ret;
+}
 
-   // Compute error
+// Compares the outputs of both implementations against the tolerance, after
+// `nb_calls` calls of each.
+static void validate_outputs(armbench_config_t *config, const kind_desc_t *desc,
+                             const buffers_t *bufs, const size_t nb_calls)
+{
+   const vectors_t *output = desc->output == OPERAND_X   ? &bufs->x
+                             : desc->output == OPERAND_Y ? &bufs->y
+                                                         : &bufs->r;
+   // Scalar results are only written for the calls that were made
+   const size_t len = output == &bufs->r ? nb_calls : output->len;
    config->computed_error =
-      compute_error(y.compiler_vec, y.assembly_vec, y.len);
+      compute_error(output->compiler_vec, output->assembly_vec, len);
    if (config->computed_error <= config->error_tolerance) {
       config->passed = true;
    }
-
-   destroy_vectors(&x);
-   destroy_vectors(&y);
-   return 0;
 }
 
-int driver_vec_sum(config_t *config)
+int driver_run(const armbench_t *bench, armbench_config_t *config,
+               const run_context_t *context)
 {
-   vectors_t x = init_vectors(config->nb_bytes, true);
-   vectors_t y = init_vectors(config->nb_bytes, true);
-   struct timespec start, end;
-
-   // Run compiler benchmark
-   clock_gettime(CLOCK_MONOTONIC_RAW, &start);
-   for (size_t i = 0; i < config->nb_repetitions; ++i) {
-      compiler_vec_sum(x.compiler_vec, y.compiler_vec, x.len);
+   const armbench_kind_t kind = config->benchmark_kind;
+   if (kind >= BENCH_KIND__MAX) {
+      return ARMBENCH_ERROR_INVALID;
    }
-   clock_gettime(CLOCK_MONOTONIC_RAW, &end);
-   config->compiler_latency =
-      compute_avg_latency(start, end, config->nb_repetitions);
-
-   // Run assembly benchmark
-   clock_gettime(CLOCK_MONOTONIC_RAW, &start);
-   for (size_t i = 0; i < config->nb_repetitions; ++i) {
-      assembly_vec_sum(x.assembly_vec, y.assembly_vec, x.len);
+   const armbench_kernel_t *compiler =
+      armbench_selected_kernel(bench, kind, IMPL_KIND_COMPILER);
+   const armbench_kernel_t *assembly =
+      armbench_selected_kernel(bench, kind, IMPL_KIND_ASSEMBLY);
+   if (!compiler || !assembly) {
+      return ARMBENCH_ERROR_INVALID;
    }
-   clock_gettime(CLOCK_MONOTONIC_RAW, &end);
-   config->assembly_latency =
-      compute_avg_latency(start, end, config->nb_repetitions);
-
-   // Compute speedup
-   config->speedup = config->compiler_latency / config->assembly_latency;
 
-   // Compute error
-   config->computed_error =
-      compute_error(x.compiler_vec, x.assembly_vec, x.len);
-   if (config->computed_error <= config->error_tolerance) {
-      config->passed = true;
+   const kind_desc_t *desc = kind_descs + kind;
+   buffers_t bufs = { 0 };
+   int ret = init_buffers(&bufs, desc, config);
+   if (ret) {
+      destroy_buffers(&bufs);
+      return ret;
    }
-
-   destroy_vectors(&x);
-   destroy_vectors(&y);
-   return 0;
-}
-
-int driver_vec_scale(config_t *config)
-{
-   vectors_t x = init_vectors(config->nb_bytes, true);
-   const double k = rand_double(-1.0, 1.0);
-   struct timespec start, end;
-
-   // Run compiler benchmark
-   clock_gettime(CLOCK_MONOTONIC_RAW, &start);
-   for (size_t i = 0; i < config->nb_repetitions; ++i) {
-      compiler_vec_scale(k, x.compiler_vec, x.len);
+   uint64_t state = config->seed;
+   const double k = desc->has_k ? rand_double(&state, -1.0, 1.0) : 0.0;
+
+   const armbench_args_t compiler_args = {
+      .k = k,
+      .x = bufs.x.compiler_vec,
+      .y = bufs.y.compiler_vec,
+      .r = bufs.r.compiler_vec,
+      .len = bufs.x.len,
+   };
+   const armbench_args_t assembly_args = {
+      .k = k,
+      .x = bufs.x.assembly_vec,
+      .y = bufs.y.assembly_vec,
+      .r = bufs.r.assembly_vec,
+      .len = bufs.x.len,
+   };
+   if (config->soak_duration > 0.0) {
+      // Only the soaked implementation keeps running, so both are validated
+      // on a single call beforehand
+      compiler->call(&compiler_args, 0);
+      assembly->call(&assembly_args, 0);
+      validate_outputs(config, desc, &bufs, 1);
+      ret = config->impl_kind == IMPL_KIND_COMPILER
+               ? soak_benchmark(config, desc, compiler->call, &compiler_args)
+               : soak_benchmark(config, desc, assembly->call, &assembly_args);
    }
-   clock_gettime(CLOCK_MONOTONIC_RAW, &end);
-   config->compiler_latency =
-      compute_avg_latency(start, end, config->nb_repetitions);
-
-   // Run assembly benchmark
-   clock_gettime(CLOCK_MONOTONIC_RAW, &start);
-   for (size_t i = 0; i < config->nb_repetitions; ++i) {
-      assembly_vec_scale(k, x.assembly_vec, x.len);
+   else {
+      ret = run_benchmark(config, context, compiler->call, &compiler_args,
+                          assembly->call, &assembly_args);
+      validate_outputs(config, desc, &bufs, config->nb_repetitions);
    }
-   clock_gettime(CLOCK_MONOTONIC_RAW, &end);
-   config->assembly_latency =
-      compute_avg_latency(start, end, config->nb_repetitions);
-
-   // Compute speedup
-   config->speedup = config->compiler_latency / config->assembly_latency;
 
-   // Compute error
-   config->computed_error =
-      compute_error(x.compiler_vec, x.assembly_vec, x.len);
-   if (config->computed_error <= config->error_tolerance) {
-      config->passed = true;
-   }
+   // Capture instruction mix
+   insn_mix_analyze(compiler->symbol, &config->compiler_mix);
+   insn_mix_analyze(assembly->symbol, &config->assembly_mix);
 
-   destroy_vectors(&x);
-   return 0;
+   destroy_buffers(&bufs);
+   return ret;
 }
@@ -0,0 +1,258 @@
+#define _GNU_SOURCE
+#include "insn_mix.h"
+
+#include <dlfcn.h>
+#include <link.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+
+typedef enum insn_class_e {
+   INSN_CLASS_SCALAR,
+   INSN_CLASS_NEON,
+   INSN_CLASS_SVE,
+} insn_class_t;
+
+typedef struct loop_s {
+   size_t head;
+   size_t tail;
+} loop_t;
+
+// SVE occupies the `op0 == 0b0010` slot of the top-level A64 encoding.
+static inline bool is_sve(const uint32_t insn)
+{
+   return ((insn >> 25) & 0xf) == 0x2;
+}
+
+// Loads and stores are encoded as `op0 == 0bx1x0`, their SVE counterparts
+// use the upper half of the SVE encoding space (`insn[31:29] >= 0b100`).
+static inline bool is_mem(const uint32_t insn)
+{
+   if (is_sve(insn)) {
+      return (insn >> 29) >= 0x4;
+   }
+   return ((insn >> 25) & 0x5) == 0x4;
+}
+
+static inline bool is_load(const uint32_t insn)
+{
+   if (is_sve(insn)) {
+      return (insn >> 29) != 0x7;
+   }
+   // Load literal
+   if (((insn >> 27) & 0x7) == 0x3 && ((insn >> 24) & 0x3) == 0x0) {
+      return true;
+   }
+   // Load/store register (unscaled, immediate, register offset): opc is
+   // `insn[23:22]`, which also encodes 128-bit SIMD&FP stores (`0b10`).
+   if (((insn >> 27) & 0x7) == 0x7) {
+      const bool simd_fp = (insn >> 26) & 0x1;
+      const uint32_t opc = (insn >> 22) & 0x3;
+      return simd_fp ? (opc & 0x1) : (opc != 0x0);
+   }
+   // Everything else (pairs, exclusives, SIMD structures) uses L at bit 22.
+   return (insn >> 22) & 0x1;
+}
+
+static inline bool is_gather(const uint32_t insn)
+{
+   if (!is_sve(insn)) {
+      return false;
+   }
+   const uint32_t op0 = insn >> 29;
+   const uint32_t op3 = (insn >> 13) & 0x7;
+   return op0 == 0x6 || (op0 == 0x7 && (op3 == 0x4 || op3 == 0x5));
+}
+
+static inline bool is_fma(const uint32_t insn)
+{
+   // SVE FMLA/FMLS/FNMLA/FNMLS/FMAD/FMSB/FNMAD/FNMSB (predicated)
+   if ((insn & 0xff200000) == 0x65200000) {
+      return true;
+   }
+   // SVE FMLA/FMLS (indexed)
+   if ((insn & 0xffa0f800) == 0x64a00000) {
+      return true;
+   }
+   // Scalar FMADD/FMSUB/FNMADD/FNMSUB
+   if ((insn & 0x5f000000) == 0x1f000000) {
+      return true;
+   }
+   // Advanced SIMD FMLA/FMLS (vector)
+   if ((insn & 0xbf20fc00) == 0x0e20cc00) {
+      return true;
+   }
+   // Advanced SIMD FMLA/FMLS (by element)
+   return (insn & 0xbf80b400) == 0x0f801000;
+}
+
+// 128-bit SIMD&FP loads and stores (`ldr q`, `ldp q`, `ld1 {v.2d}`) move full
+// Advanced SIMD registers, narrower ones only feed scalar FP code.
+static inline bool is_neon_mem(const uint32_t insn)
+{
+   if (!((insn >> 26) & 0x1)) {
+      return false;
+   }
+   // Groups are told apart by `insn[29:27]`
+   switch ((insn >> 27) & 0x7) {
+      case 0x1:
+         // Structure loads and stores
+         return true;
+      case 0x3:
+      case 0x5:
+         // Literal loads and register pairs, `opc == 0b10` is the Q form
+         return (insn >> 30) == 0x2;
+      case 0x7:
+         // Single registers, `size == 0b00` with `opc[1]` is the Q form
+         return (insn >> 30) == 0x0 && ((insn >> 23) & 0x1);
+      default:
+         return false;
+   }
+}
+
+static inline insn_class_t classify(const uint32_t insn)
+{
+   if (is_sve(insn)) {
+      return INSN_CLASS_SVE;
+   }
+   if (is_mem(insn)) {
+      return is_neon_mem(insn) ? INSN_CLASS_NEON : INSN_CLASS_SCALAR;
+   }
+   // Advanced SIMD vector forms sit in the SIMD&FP data processing group
+   // (`op0 == 0bx111`) with `insn[28] == 0`.
+   if (((insn >> 25) & 0x7) == 0x7 && !((insn >> 28) & 0x1)) {
+      return INSN_CLASS_NEON;
+   }
+   return INSN_CLASS_SCALAR;
+}
+
+static inline int64_t sign_extend(const uint32_t value, const unsigned bits)
+{
+   const uint64_t mask = 1ull << (bits - 1);
+   return (int64_t)((value ^ mask) - mask);
+}
+
+// Returns the branch offset in instructions, or 0 if `insn` is not a
+// direct branch.
+static inline int64_t branch_offset(const uint32_t insn)
+{
+   // B
+   if ((insn & 0xfc000000) == 0x14000000) {
+      return sign_extend(insn & 0x3ffffff, 26);
+   }
+   // B.cond
+   if ((insn & 0xff000010) == 0x54000000) {
+      return sign_extend((insn >> 5) & 0x7ffff, 19);
+   }
+   // CBZ/CBNZ
+   if ((insn & 0x7e000000) == 0x34000000) {
+      return sign_extend((insn >> 5) & 0x7ffff, 19);
+   }
+   // TBZ/TBNZ
+   if ((insn & 0x7e000000) == 0x36000000) {
+      return sign_extend((insn >> 5) & 0x3fff, 14);
+   }
+   return 0;
+}
+
+static void count_range(const uint32_t *code, const loop_t loop,
+                        armbench_insn_mix_t *mix)
+{
+   for (size_t i = loop.head; i <= loop.tail; ++i) {
+      const uint32_t insn = code[i];
+      switch (classify(insn)) {
+         case INSN_CLASS_SVE:
+            mix->nb_sve++;
+            break;
+         case INSN_CLASS_NEON:
+            mix->nb_neon++;
+            break;
+         default:
+            mix->nb_scalar++;
+            break;
+      }
+      if (is_mem(insn)) {
+         if (is_load(insn)) {
+            mix->nb_loads++;
+         }
+         else {
+            mix->nb_stores++;
+         }
+      }
+      if (is_fma(insn)) {
+         mix->nb_fmas++;
+      }
+      if (is_gather(insn)) {
+         mix->nb_gathers++;
+      }
+   }
+   mix->loop_insns = loop.tail - loop.head + 1;
+}
+
+static bool contains_loop(const uint32_t *code, const loop_t loop)
+{
+   for (size_t i = loop.head; i < loop.tail; ++i) {
+      const int64_t off = branch_offset(code[i]);
+      if (off < 0 && (int64_t)i + off >= (int64_t)loop.head) {
+         return true;
+      }
+   }
+   return false;
+}
+
+// The hot loop is the innermost backward branch whose body holds the most
+// vector instructions. Scalar remainder loops and outer loops are skipped.
+static void find_hot_loop(const uint32_t *code, const size_t len,
+                          armbench_insn_mix_t *mix)
+{
+   armbench_insn_mix_t best = { 0 };
+   for (size_t i = 0; i < len; ++i) {
+      const int64_t off = branch_offset(code[i]);
+      if (off >= 0 || (int64_t)i + off < 0) {
+         continue;
+      }
+      const loop_t loop = { .head = i + off, .tail = i };
+      if (contains_loop(code, loop)) {
+         continue;
+      }
+
+      armbench_insn_mix_t candidate = { 0 };
+      count_range(code, loop, &candidate);
+      const size_t vec = candidate.nb_sve + candidate.nb_neon;
+      const size_t best_vec = best.nb_sve + best.nb_neon;
+      if (!best.loop_insns || vec > best_vec ||
+          (vec == best_vec && candidate.loop_insns > best.loop_insns)) {
+         best = candidate;
+      }
+   }
+
+   best.available = mix->available;
+   best.function_insns = mix->function_insns;
+   *mix = best;
+}
+
+int insn_mix_analyze(const void *function, armbench_insn_mix_t *mix)
+{
+   memset(mix, 0, sizeof(*mix));
+
+#if !defined(__aarch64__)
+   // The decoder only understands A64 machine code
+   return -1;
+#endif
+
+   // The size of the enclosing symbol only bounds the code if `function` is
+   // its start, not a label inside it
+   Dl_info info;
+   const ElfW(Sym) *sym = NULL;
+   if (!function ||
+       !dladdr1(function, &info, (void **)&sym, RTLD_DL_SYMENT) || !sym ||
+       info.dli_saddr != function || !sym->st_size) {
+      return -1;
+   }
+
+   const uint32_t *code = (const uint32_t *)function;
+   mix->function_insns = sym->st_size / sizeof(uint32_t);
+   mix->available = true;
+   find_hot_loop(code, mix->function_insns, mix);
+   return 0;
+}
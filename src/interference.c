@@ -0,0 +1,276 @@
+#define _GNU_SOURCE
+#include "interference.h"
+
+#include "armbench.h"
+#include "consts.h"
+#include "drivers.h"
+#include "kernels.h"
+#include "utils.h"
+
+#include <pthread.h>
+#include <sched.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <time.h>
+
+typedef struct background_s {
+   pthread_t thread;
+   int cpu;
+   armbench_bg_load_t load;
+   size_t duty_cycle;
+   atomic_size_t *ready;
+   atomic_bool *failed;
+   atomic_bool *stop;
+   atomic_size_t *nb_bytes;
+} background_t;
+
+// Reads `count` elements of `x` at pseudo-random indices, defeating the
+// prefetchers.
+static double random_load(const double *restrict x, const size_t len,
+                          const size_t count, uint64_t *seed)
+{
+   uint64_t idx = *seed;
+   double acc = 0.0;
+   for (size_t i = 0; i < count; ++i) {
+      idx = idx * 6364136223846793005ull + 1442695040888963407ull;
+      acc += x[(idx >> 16) % len];
+   }
+   *seed = idx;
+   return acc;
+}
+
+// Runs the background load over the chunk starting at `offset` and returns
+// the number of bytes it moved to or from memory.
+static size_t background_pass(const armbench_bg_load_t load, double *x,
+                              double *y, const size_t len, const size_t offset,
+                              uint64_t *seed)
+{
+   const size_t chunk = BACKGROUND_CHUNK / sizeof(double);
+   switch (load) {
+      case BG_LOAD_COPY:
+         assembly_copy(x + offset, y + offset, chunk);
+         return 2 * BACKGROUND_CHUNK;
+      case BG_LOAD_INIT:
+         assembly_init(1.0, x + offset, chunk);
+         return BACKGROUND_CHUNK;
+      case BG_LOAD_RANDOM: {
+         volatile double sink = random_load(x, len, chunk, seed);
+         (void)sink;
+         return BACKGROUND_CHUNK;
+      }
+      default:
+         return 0;
+   }
+}
+
+/**
+ * Accumulates the bytes moved by the background threads while the benchmark
+ * is inside a timed section, so that setup, validation and cache flushes do
+ * not dilute the reported bandwidth.
+ **/
+typedef struct bandwidth_probe_s {
+   atomic_size_t *nb_bytes;
+   size_t bytes_start;
+   struct timespec start;
+   size_t nb_bytes_timed;
+   double nb_ns_timed;
+} bandwidth_probe_t;
+
+static void bandwidth_section(void *data, const bool begin)
+{
+   bandwidth_probe_t *probe = data;
+   struct timespec now;
+   clock_gettime(CLOCK_MONOTONIC_RAW, &now);
+   const size_t nb_bytes = atomic_load(probe->nb_bytes);
+   if (begin) {
+      probe->bytes_start = nb_bytes;
+      probe->start = now;
+      return;
+   }
+   probe->nb_bytes_timed += nb_bytes - probe->bytes_start;
+   probe->nb_ns_timed += elapsed_ns(probe->start, now);
+}
+
+static void *background_thread(void *arg)
+{
+   background_t *bg = arg;
+   const size_t len = BACKGROUND_SIZE / sizeof(double);
+   double *x = aligned_alloc(ALIGNMENT, BACKGROUND_SIZE);
+   double *y = aligned_alloc(ALIGNMENT, BACKGROUND_SIZE);
+   if (x && y) {
+      for (size_t i = 0; i < len; ++i) {
+         x[i] = 1.0;
+         y[i] = 2.0;
+      }
+   }
+   else {
+      atomic_store(bg->failed, true);
+   }
+   atomic_fetch_add(bg->ready, 1);
+
+   size_t offset = 0;
+   uint64_t seed = 0;
+   while (x && y && !atomic_load_explicit(bg->stop, memory_order_relaxed)) {
+      struct timespec start, end;
+      clock_gettime(CLOCK_MONOTONIC_RAW, &start);
+      const size_t nb_bytes =
+         background_pass(bg->load, x, y, len, offset, &seed);
+      clock_gettime(CLOCK_MONOTONIC_RAW, &end);
+      atomic_fetch_add_explicit(bg->nb_bytes, nb_bytes, memory_order_relaxed);
+      offset = (offset + BACKGROUND_CHUNK / sizeof(double)) % len;
+
+      // Throttle to the requested duty cycle by idling after each chunk
+      if (bg->duty_cycle < 100) {
+         const double busy = elapsed_ns(start, end);
+         const double idle =
+            busy * (double)(100 - bg->duty_cycle) / (double)(bg->duty_cycle);
+         const struct timespec pause = {
+            .tv_sec = (time_t)(idle / 1e9),
+            .tv_nsec = (long)(idle - (double)((time_t)(idle / 1e9)) * 1e9),
+         };
+         nanosleep(&pause, NULL);
+      }
+   }
+
+   free(x);
+   free(y);
+   return NULL;
+}
+
+// Measures the selected kernel while `nb_threads` background threads run.
+static int run_level(const armbench_t *bench, armbench_config_t *config,
+                     const int *cpus, const size_t nb_threads,
+                     armbench_interference_result_t *result)
+{
+   background_t bgs[nb_threads + 1];
+   atomic_size_t ready;
+   atomic_bool failed;
+   atomic_bool stop;
+   atomic_size_t nb_bytes;
+   atomic_init(&ready, 0);
+   atomic_init(&failed, false);
+   atomic_init(&stop, false);
+   atomic_init(&nb_bytes, 0);
+
+   size_t nb_started = 0;
+   for (; nb_started < nb_threads; ++nb_started) {
+      background_t *bg = bgs + nb_started;
+      bg->cpu = cpus[nb_started + 1];
+      bg->load = config->bg_load;
+      bg->duty_cycle = config->bg_duty_cycle;
+      bg->ready = &ready;
+      bg->failed = &failed;
+      bg->stop = &stop;
+      bg->nb_bytes = &nb_bytes;
+
+      // Pin before the thread starts so that its buffers are first touched
+      // from its own core
+      cpu_set_t set;
+      CPU_ZERO(&set);
+      CPU_SET(bg->cpu, &set);
+      pthread_attr_t attr;
+      pthread_attr_init(&attr);
+      pthread_attr_setaffinity_np(&attr, sizeof(set), &set);
+      const int err =
+         pthread_create(&bg->thread, &attr, background_thread, bg);
+      pthread_attr_destroy(&attr);
+      if (err) {
+         break;
+      }
+   }
+   if (nb_started < nb_threads) {
+      atomic_store(&stop, true);
+      for (size_t i = 0; i < nb_started; ++i) {
+         pthread_join(bgs[i].thread, NULL);
+      }
+      return ARMBENCH_ERROR_SYSTEM;
+   }
+   while (atomic_load(&ready) < nb_threads) {
+   }
+   // A thread without buffers generates no load
+   if (atomic_load(&failed)) {
+      atomic_store(&stop, true);
+      for (size_t i = 0; i < nb_threads; ++i) {
+         pthread_join(bgs[i].thread, NULL);
+      }
+      return ARMBENCH_ERROR_ALLOC;
+   }
+
+   bandwidth_probe_t probe = { .nb_bytes = &nb_bytes };
+   const run_context_t context = {
+      .section_hook = bandwidth_section,
+      .section_data = &probe,
+   };
+   config->passed = false;
+   const int ret = driver_run(bench, config, &context);
+
+   atomic_store(&stop, true);
+   for (size_t i = 0; i < nb_threads; ++i) {
+      pthread_join(bgs[i].thread, NULL);
+   }
+
+   result->nb_threads = nb_threads;
+   result->compiler_latency = config->compiler_latency;
+   result->assembly_latency = config->assembly_latency;
+   result->background_bandwidth =
+      probe.nb_ns_timed > 0.0
+         ? (double)(probe.nb_bytes_timed) / probe.nb_ns_timed
+         : 0.0;
+   result->passed = config->passed;
+   return ret;
+}
+
+int interference_run(const armbench_t *bench, armbench_config_t *config)
+{
+   // Bounds the arrays of every level, whatever the caller asked for
+   if (config->nb_bg_threads >= nb_allowed_cpus()) {
+      return ARMBENCH_ERROR_CPUS;
+   }
+   const size_t nb_levels = config->nb_bg_threads + 1;
+   int cpus[nb_levels];
+   if (allowed_cpus(cpus, nb_levels) < nb_levels) {
+      return ARMBENCH_ERROR_CPUS;
+   }
+
+   // The caller is pinned for the duration of the run only
+   cpu_set_t saved;
+   if (pthread_getaffinity_np(pthread_self(), sizeof(saved), &saved)) {
+      return ARMBENCH_ERROR_SYSTEM;
+   }
+   cpu_set_t set;
+   CPU_ZERO(&set);
+   CPU_SET(cpus[0], &set);
+   if (pthread_setaffinity_np(pthread_self(), sizeof(set), &set)) {
+      return ARMBENCH_ERROR_SYSTEM;
+   }
+
+   int ret = ARMBENCH_SUCCESS;
+   armbench_interference_result_t *results =
+      malloc(nb_levels * sizeof(armbench_interference_result_t));
+   if (!results) {
+      ret = ARMBENCH_ERROR_ALLOC;
+   }
+
+   // The isolated run is kept as the main result of the benchmark
+   armbench_config_t baseline = *config;
+   bool passed = true;
+   for (size_t i = 0; !ret && i < nb_levels; ++i) {
+      ret = run_level(bench, config, cpus, i, results + i);
+      if (!i) {
+         baseline = *config;
+      }
+      passed &= results[i].passed;
+   }
+
+   pthread_setaffinity_np(pthread_self(), sizeof(saved), &saved);
+   if (ret) {
+      free(results);
+      return ret;
+   }
+   *config = baseline;
+   config->passed = passed;
+   config->interference_results = results;
+   return ARMBENCH_SUCCESS;
+}
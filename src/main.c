@@ -1,6 +1,5 @@
-#include "config.h"
-#include "consts.h"
-#include "drivers.h"
+#include "armbench.h"
+#include "cli.h"
 #include "logs.h"
 
 #include <stdio.h>
@@ -8,48 +7,38 @@
 
 int main(int argc, char *argv[argc + 1])
 {
-   config_t config = {
-      .benchmark_kind = BENCH_KIND__MAX,
-      .nb_bytes = DEFAULT_SIZE,
-      .nb_repetitions = DEFAULT_REP,
-      .error_tolerance = DEFAULT_ERROR,
-      .computed_error = 0.0,
-      .compiler_latency = 0.0,
-      .assembly_latency = 0.0,
-      .speedup = 0.0,
-      .passed = false,
-   };
+   armbench_config_t config;
+   armbench_default_config(&config);
 
    config_init(&config, argc, argv);
    config_print(&config);
 
-   switch (config.benchmark_kind) {
-      case BENCH_KIND_INIT:
-         driver_init(&config);
-         break;
-      case BENCH_KIND_COPY:
-         driver_copy(&config);
-         break;
-      case BENCH_KIND_REDUC:
-         driver_reduc(&config);
-         break;
-      case BENCH_KIND_DOTPROD:
-         driver_dotprod(&config);
-         break;
-      case BENCH_KIND_GAXPY:
-         driver_gaxpy(&config);
-         break;
-      case BENCH_KIND_SUM:
-         driver_vec_sum(&config);
-         break;
-      case BENCH_KIND_SCALE:
-         driver_vec_scale(&config);
-         break;
-      default:
-         log_error("unreachable");
-         exit(EXIT_FAILURE);
+   armbench_t *bench = armbench_create();
+   if (!bench) {
+      log_error("failed to create the benchmark handle.");
+      exit(EXIT_FAILURE);
+   }
+
+   const int ret = armbench_run(bench, &config);
+   if (ret == ARMBENCH_ERROR_CPUS && config.nb_procs > 1) {
+      log_error("failed to run the benchmark on %zu processes "
+                "(are there enough CPUs available?).",
+                config.nb_procs);
+      exit(EXIT_FAILURE);
+   }
+   else if (ret == ARMBENCH_ERROR_CPUS) {
+      log_error("failed to run the benchmark against %zu background "
+                "threads (are there enough CPUs available?).",
+                config.nb_bg_threads);
+      exit(EXIT_FAILURE);
+   }
+   else if (ret) {
+      log_error("failed to run the benchmark: %s.", armbench_strerror(ret));
+      exit(EXIT_FAILURE);
    }
 
    config_result(&config);
+   armbench_free_results(&config);
+   armbench_destroy(bench);
    return 0;
 }
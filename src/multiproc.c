@@ -0,0 +1,194 @@
+#define _GNU_SOURCE
+#include "multiproc.h"
+
+#include "armbench.h"
+#include "consts.h"
+#include "drivers.h"
+#include "utils.h"
+
+#include <sched.h>
+#include <signal.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+typedef struct shm_region_s {
+   shm_barrier_t barrier;
+   armbench_proc_result_t results[];
+} shm_region_t;
+
+void shm_barrier_wait(shm_barrier_t *barrier)
+{
+   const size_t generation =
+      atomic_load_explicit(&barrier->generation, memory_order_acquire);
+   if (atomic_fetch_add_explicit(&barrier->count, 1, memory_order_acq_rel) +
+          1 ==
+       barrier->nb_procs) {
+      atomic_store_explicit(&barrier->count, 0, memory_order_relaxed);
+      atomic_fetch_add_explicit(&barrier->generation, 1, memory_order_release);
+      return;
+   }
+   while (atomic_load_explicit(&barrier->generation, memory_order_acquire) ==
+          generation) {
+   }
+}
+
+static void run_worker(const armbench_t *bench, armbench_config_t *config,
+                       shm_region_t *shm, const size_t rank)
+{
+   armbench_proc_result_t *result = shm->results + rank;
+
+   cpu_set_t set;
+   CPU_ZERO(&set);
+   CPU_SET(result->cpu, &set);
+   if (sched_setaffinity(0, sizeof(set), &set)) {
+      _exit(EXIT_FAILURE);
+   }
+
+   const run_context_t context = { .barrier = &shm->barrier };
+   config->proc_results = NULL;
+   const int ret = driver_run(bench, config, &context);
+   result->config = *config;
+   _exit(ret ? EXIT_FAILURE : EXIT_SUCCESS);
+}
+
+static void kill_workers(const pid_t *pids, const size_t nb_pids)
+{
+   for (size_t i = 0; i < nb_pids; ++i) {
+      if (pids[i] > 0) {
+         kill(pids[i], SIGKILL);
+      }
+   }
+}
+
+// Waits for all workers, killing the remaining ones as soon as one of them
+// fails so that they do not spin forever on the barrier. Only the forked
+// workers are reaped, other children of the caller are left alone.
+static int wait_workers(pid_t *pids, const size_t nb_pids)
+{
+   int ret = 0;
+   size_t nb_running = nb_pids;
+   while (nb_running) {
+      size_t nb_reaped = 0;
+      for (size_t i = 0; i < nb_pids; ++i) {
+         if (pids[i] <= 0) {
+            continue;
+         }
+         int status;
+         const pid_t pid = waitpid(pids[i], &status, WNOHANG);
+         if (!pid) {
+            continue;
+         }
+         pids[i] = 0;
+         nb_reaped++;
+         if (pid < 0 || !WIFEXITED(status) ||
+             WEXITSTATUS(status) != EXIT_SUCCESS) {
+            kill_workers(pids, nb_pids);
+            ret = -1;
+         }
+      }
+      nb_running -= nb_reaped;
+      if (!nb_reaped) {
+         usleep(WAIT_INTERVAL_US);
+      }
+   }
+   return ret;
+}
+
+static void aggregate_results(armbench_config_t *config,
+                              const armbench_proc_result_t *results)
+{
+   const size_t nb_procs = config->nb_procs;
+
+   config->compiler_latency = 0.0;
+   config->assembly_latency = 0.0;
+   config->compiler_cold_latency = 0.0;
+   config->assembly_cold_latency = 0.0;
+   config->computed_error = 0.0;
+   config->passed = true;
+   for (size_t i = 0; i < nb_procs; ++i) {
+      const armbench_config_t *proc = &results[i].config;
+      config->compiler_latency += proc->compiler_latency;
+      config->assembly_latency += proc->assembly_latency;
+      config->compiler_cold_latency += proc->compiler_cold_latency;
+      config->assembly_cold_latency += proc->assembly_cold_latency;
+      if (proc->computed_error > config->computed_error) {
+         config->computed_error = proc->computed_error;
+      }
+      config->passed &= proc->passed;
+   }
+   config->compiler_latency /= (double)(nb_procs);
+   config->assembly_latency /= (double)(nb_procs);
+   config->compiler_cold_latency /= (double)(nb_procs);
+   config->assembly_cold_latency /= (double)(nb_procs);
+   config->speedup = config->compiler_latency / config->assembly_latency;
+   config->cold_speedup =
+      config->compiler_cold_latency / config->assembly_cold_latency;
+   config->compiler_mix = results[0].config.compiler_mix;
+   config->assembly_mix = results[0].config.assembly_mix;
+}
+
+int multiproc_run(const armbench_t *bench, armbench_config_t *config)
+{
+   // Bounds the arrays below, whatever the caller asked for
+   const size_t nb_procs = config->nb_procs;
+   if (nb_procs > nb_allowed_cpus()) {
+      return ARMBENCH_ERROR_CPUS;
+   }
+   int cpus[nb_procs];
+   if (allowed_cpus(cpus, nb_procs) < nb_procs) {
+      return ARMBENCH_ERROR_CPUS;
+   }
+
+   const size_t shm_size =
+      sizeof(shm_region_t) + nb_procs * sizeof(armbench_proc_result_t);
+   shm_region_t *shm = mmap(NULL, shm_size, PROT_READ | PROT_WRITE,
+                            MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+   if (shm == MAP_FAILED) {
+      return ARMBENCH_ERROR_SYSTEM;
+   }
+   atomic_init(&shm->barrier.count, 0);
+   atomic_init(&shm->barrier.generation, 0);
+   shm->barrier.nb_procs = nb_procs;
+
+   // Do not let the workers inherit (and flush) pending output
+   fflush(stdout);
+
+   pid_t pids[nb_procs];
+   memset(pids, 0, sizeof(pids));
+   for (size_t i = 0; i < nb_procs; ++i) {
+      shm->results[i].cpu = cpus[i];
+      pids[i] = fork();
+      if (pids[i] < 0) {
+         kill_workers(pids, i);
+         wait_workers(pids, i);
+         munmap(shm, shm_size);
+         return ARMBENCH_ERROR_SYSTEM;
+      }
+      if (!pids[i]) {
+         run_worker(bench, config, shm, i);
+      }
+   }
+
+   if (wait_workers(pids, nb_procs)) {
+      munmap(shm, shm_size);
+      return ARMBENCH_ERROR_SYSTEM;
+   }
+
+   config->proc_results = malloc(nb_procs * sizeof(armbench_proc_result_t));
+   if (!config->proc_results) {
+      munmap(shm, shm_size);
+      return ARMBENCH_ERROR_ALLOC;
+   }
+   memcpy(config->proc_results, shm->results,
+          nb_procs * sizeof(armbench_proc_result_t));
+   aggregate_results(config, config->proc_results);
+
+   munmap(shm, shm_size);
+   return ARMBENCH_SUCCESS;
+}
@@ -0,0 +1,54 @@
+#include "kernels.h"
+
+#include "consts.h"
+
+// The summation order is what sets these variants apart, so value-unsafe
+// optimizations must not reassociate it (see the Makefile).
+#if defined(__FAST_MATH__)
+#error "pairwise.c must be compiled without -ffast-math"
+#endif
+
+// Sums blocks of `PAIRWISE_BLOCK` elements naively and combines them
+// pairwise, so that the error grows with log2(len) instead of len.
+static double pairwise_sum(const double *restrict x, const size_t len)
+{
+   if (len <= PAIRWISE_BLOCK) {
+      double acc = 0.0;
+      for (size_t i = 0; i < len; ++i) {
+         acc += x[i];
+      }
+      return acc;
+   }
+   const size_t half = (len / 2 + PAIRWISE_BLOCK - 1) / PAIRWISE_BLOCK *
+                       PAIRWISE_BLOCK;
+   return pairwise_sum(x, half) + pairwise_sum(x + half, len - half);
+}
+
+static double pairwise_dot(const double *restrict x, const double *restrict y,
+                           const size_t len)
+{
+   if (len <= PAIRWISE_BLOCK) {
+      double acc = 0.0;
+      for (size_t i = 0; i < len; ++i) {
+         acc += (x[i] * y[i]);
+      }
+      return acc;
+   }
+   const size_t half = (len / 2 + PAIRWISE_BLOCK - 1) / PAIRWISE_BLOCK *
+                       PAIRWISE_BLOCK;
+   return pairwise_dot(x, y, half) +
+          pairwise_dot(x + half, y + half, len - half);
+}
+
+void compiler_reduc_pairwise(const double *restrict x, double *r,
+                             const size_t len)
+{
+   *r = pairwise_sum(x, len);
+}
+
+void compiler_dotprod_pairwise(const double *restrict x,
+                               const double *restrict y, double *d,
+                               const size_t len)
+{
+   *d = pairwise_dot(x, y, len);
+}
@@ -0,0 +1,226 @@
+#define _GNU_SOURCE
+#include "soak.h"
+
+#include "armbench.h"
+#include "consts.h"
+#include "kernels.h"
+#include "utils.h"
+
+#include <math.h>
+#include <pthread.h>
+#include <sched.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+typedef struct raw_sample_s {
+   double timestamp;
+   size_t nb_calls;
+   double elapsed;
+   int cpu;
+} raw_sample_t;
+
+/**
+ * Single-producer single-consumer ring buffer: the benchmark thread pushes
+ * samples without ever blocking, the reporter thread drains them.
+ **/
+typedef struct soak_ring_s {
+   atomic_size_t head;
+   atomic_size_t tail;
+   size_t nb_dropped;
+   raw_sample_t slots[SOAK_RING_SIZE];
+} soak_ring_t;
+
+typedef struct reporter_s {
+   soak_ring_t *ring;
+   atomic_bool done;
+   double interval;
+   armbench_soak_sample_t *samples;
+   size_t nb_samples;
+   size_t max_samples;
+   size_t nb_dropped;
+} reporter_t;
+
+static void ring_push(soak_ring_t *ring, const raw_sample_t *sample)
+{
+   const size_t head = atomic_load_explicit(&ring->head, memory_order_relaxed);
+   const size_t tail = atomic_load_explicit(&ring->tail, memory_order_acquire);
+   if (head - tail == SOAK_RING_SIZE) {
+      ring->nb_dropped++;
+      return;
+   }
+   ring->slots[head % SOAK_RING_SIZE] = *sample;
+   atomic_store_explicit(&ring->head, head + 1, memory_order_release);
+}
+
+static bool ring_pop(soak_ring_t *ring, raw_sample_t *sample)
+{
+   const size_t tail = atomic_load_explicit(&ring->tail, memory_order_relaxed);
+   const size_t head = atomic_load_explicit(&ring->head, memory_order_acquire);
+   if (tail == head) {
+      return false;
+   }
+   *sample = ring->slots[tail % SOAK_RING_SIZE];
+   atomic_store_explicit(&ring->tail, tail + 1, memory_order_release);
+   return true;
+}
+
+// Stores the scaled value of `path` in `value` (0 when it cannot be parsed),
+// and returns whether the file exists.
+static bool read_sysfs(const char *path, const double scale, double *value)
+{
+   *value = 0.0;
+   FILE *file = fopen(path, "r");
+   if (!file) {
+      return false;
+   }
+   double raw;
+   if (fscanf(file, "%lf", &raw) == 1) {
+      *value = raw * scale;
+   }
+   fclose(file);
+   return true;
+}
+
+// Current frequency of `cpu` in MHz.
+static double read_frequency(const int cpu)
+{
+   char path[128];
+   snprintf(path, sizeof(path),
+            "/sys/devices/system/cpu/cpu%d/cpufreq/scaling_cur_freq", cpu);
+   double frequency;
+   read_sysfs(path, 1e-3, &frequency);
+   return frequency;
+}
+
+// Temperature of the hottest thermal zone in °C.
+static double read_temperature(void)
+{
+   double max = 0.0;
+   for (int zone = 0;; ++zone) {
+      char path[128];
+      snprintf(path, sizeof(path), "/sys/class/thermal/thermal_zone%d/temp",
+               zone);
+      double temp;
+      if (!read_sysfs(path, 1e-3, &temp)) {
+         break;
+      }
+      if (temp > max) {
+         max = temp;
+      }
+   }
+   return max;
+}
+
+static void *reporter_thread(void *arg)
+{
+   reporter_t *reporter = arg;
+   const double pause_ns = reporter->interval * 1e9 / 4.0;
+   const struct timespec pause = {
+      .tv_sec = (time_t)(pause_ns / 1e9),
+      .tv_nsec = (long)(pause_ns - (double)((time_t)(pause_ns / 1e9)) * 1e9),
+   };
+
+   bool done = false;
+   while (true) {
+      raw_sample_t raw;
+      if (!ring_pop(reporter->ring, &raw)) {
+         if (done) {
+            break;
+         }
+         // The last samples may be pushed right before `done` is set, so the
+         // ring is drained once more after seeing it
+         done = atomic_load(&reporter->done);
+         if (!done) {
+            nanosleep(&pause, NULL);
+         }
+         continue;
+      }
+      if (reporter->nb_samples == reporter->max_samples) {
+         reporter->nb_dropped++;
+         continue;
+      }
+      reporter->samples[reporter->nb_samples++] = (armbench_soak_sample_t){
+         .timestamp = raw.timestamp,
+         .nb_calls = raw.nb_calls,
+         .elapsed = raw.elapsed,
+         .frequency = read_frequency(raw.cpu),
+         .temperature = read_temperature(),
+      };
+   }
+   return NULL;
+}
+
+int soak_run(armbench_config_t *config, const armbench_call_t call,
+             const armbench_args_t args[2])
+{
+   const double duration_ns = config->soak_duration * 1e9;
+   const double interval_ns = config->soak_interval * 1e9;
+
+   soak_ring_t *ring = malloc(sizeof(soak_ring_t));
+   reporter_t reporter = {
+      .ring = ring,
+      .interval = config->soak_interval,
+      .max_samples =
+         (size_t)(ceil(config->soak_duration / config->soak_interval)) + 1,
+      .nb_samples = 0,
+      .nb_dropped = 0,
+   };
+   reporter.samples =
+      malloc(reporter.max_samples * sizeof(armbench_soak_sample_t));
+   if (!ring || !reporter.samples) {
+      free(ring);
+      free(reporter.samples);
+      return ARMBENCH_ERROR_ALLOC;
+   }
+   atomic_init(&ring->head, 0);
+   atomic_init(&ring->tail, 0);
+   ring->nb_dropped = 0;
+   atomic_init(&reporter.done, false);
+
+   pthread_t thread;
+   if (pthread_create(&thread, NULL, reporter_thread, &reporter)) {
+      free(ring);
+      free(reporter.samples);
+      return ARMBENCH_ERROR_SYSTEM;
+   }
+
+   struct timespec start, window, now;
+   size_t nb_calls = 0, parity = 0;
+   clock_gettime(CLOCK_MONOTONIC_RAW, &start);
+   window = start;
+   while (true) {
+      call(args + parity, 0);
+      parity ^= 1;
+      nb_calls++;
+      clock_gettime(CLOCK_MONOTONIC_RAW, &now);
+
+      const double elapsed = elapsed_ns(window, now);
+      if (elapsed < interval_ns) {
+         continue;
+      }
+      const raw_sample_t sample = {
+         .timestamp = elapsed_ns(start, now) / 1e9,
+         .nb_calls = nb_calls,
+         .elapsed = elapsed,
+         .cpu = sched_getcpu(),
+      };
+      ring_push(ring, &sample);
+      nb_calls = 0;
+      window = now;
+      if (elapsed_ns(start, now) >= duration_ns) {
+         break;
+      }
+   }
+
+   atomic_store(&reporter.done, true);
+   pthread_join(thread, NULL);
+
+   config->soak_samples = reporter.samples;
+   config->nb_soak_samples = reporter.nb_samples;
+   config->nb_soak_dropped = ring->nb_dropped + reporter.nb_dropped;
+   free(ring);
+   return ARMBENCH_SUCCESS;
+}
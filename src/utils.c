@@ -1,20 +1,37 @@
+#define _GNU_SOURCE
 #include "utils.h"
 
 #include <math.h>
+#include <sched.h>
 #include <stdlib.h>
 
-inline double rand_double(const double min, const double max)
+// SplitMix64 step, so that each caller owns its generator state.
+static inline uint64_t rand_next(uint64_t *state)
 {
-   return min + ((double)(rand()) / (double)(RAND_MAX) / (max - min));
+   uint64_t z = (*state += 0x9e3779b97f4a7c15ull);
+   z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ull;
+   z = (z ^ (z >> 27)) * 0x94d049bb133111ebull;
+   return z ^ (z >> 31);
+}
+
+inline double rand_double(uint64_t *state, const double min, const double max)
+{
+   const double unit = (double)(rand_next(state) >> 11) * 0x1.0p-53;
+   return min + unit * (max - min);
+}
+
+inline double elapsed_ns(const struct timespec start,
+                         const struct timespec end)
+{
+   return (double)((end.tv_sec - start.tv_sec) * 1e9) +
+          (double)(end.tv_nsec - start.tv_nsec);
 }
 
 inline double compute_avg_latency(const struct timespec start,
                                   const struct timespec end,
                                   const size_t nb_repetitions)
 {
-   return (double)((double)((end.tv_sec - start.tv_sec) * 1e9) +
-                   (end.tv_nsec - start.tv_nsec)) /
-          (double)(nb_repetitions) / 1e3;
+   return elapsed_ns(start, end) / (double)(nb_repetitions) / 1e3;
 }
 
 double compute_error(const double *compiler, const double *assembly,
@@ -27,3 +44,48 @@ double compute_error(const double *compiler, const double *assembly,
    return err / (double)(len);
 }
 
+
+stats_t compute_stats(const double *samples, const size_t len)
+{
+   stats_t stats = { .min = samples[0], .max = samples[0], .mean = 0.0 };
+   for (size_t i = 0; i < len; ++i) {
+      stats.min = fmin(stats.min, samples[i]);
+      stats.max = fmax(stats.max, samples[i]);
+      stats.mean += samples[i];
+   }
+   stats.mean /= (double)(len);
+
+   double var = 0.0;
+   for (size_t i = 0; i < len; ++i) {
+      var += (samples[i] - stats.mean) * (samples[i] - stats.mean);
+   }
+   stats.stddev = sqrt(var / (double)(len));
+   return stats;
+}
+
+size_t nb_allowed_cpus(void)
+{
+   cpu_set_t set;
+   CPU_ZERO(&set);
+   if (sched_getaffinity(0, sizeof(set), &set)) {
+      return 0;
+   }
+   return (size_t)(CPU_COUNT(&set));
+}
+
+size_t allowed_cpus(int *cpus, const size_t max)
+{
+   cpu_set_t set;
+   CPU_ZERO(&set);
+   if (sched_getaffinity(0, sizeof(set), &set)) {
+      return 0;
+   }
+
+   size_t nb_cpus = 0;
+   for (int cpu = 0; cpu < CPU_SETSIZE && nb_cpus < max; ++cpu) {
+      if (CPU_ISSET(cpu, &set)) {
+         cpus[nb_cpus++] = cpu;
+      }
+   }
+   return nb_cpus;
+}